@@ -0,0 +1,112 @@
+/***************************************************************
+Copyright © wkangk <wangkangchn@163.com>
+文件名		: 5_deque_segment.cpp
+作者	  	: wkangk <wangkangchn@163.com>
+版本	   	: v1.0
+描述	   	: deque 段大小对迭代器运算、随机访问的影响
+            默认的段大小是编译期确定的 2 的幂, 与不是 2 的幂的段大小比较
+            g++ 5_deque_segment.cpp -O2 -std=c++11 -o app && ./app
+时间	   	: 2026-10-16 21:30
+***************************************************************/
+#include <stdint.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../wkangk/deque.h"
+
+using namespace std;
+
+
+struct LargeStruct
+{
+    int64_t key;
+    char payload[120];
+};
+
+const size_t N = 1 << 20;
+const size_t ROUNDS = 8;
+
+
+/* 随机下标, 每种 deque 用同一组 */
+vector<size_t> make_indices(size_t n)
+{
+    vector<size_t> idx(n);
+    uint64_t x = 88172645463325252ull;
+    for (size_t i = 0; i < n; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        idx[i] = x % n;
+    }
+    return idx;
+}
+
+inline int64_t key_of(int v) { return v; }
+inline int64_t key_of(const LargeStruct& v) { return v.key; }
+
+inline void set_key(int& v, size_t i) { v = (int)i; }
+inline void set_key(LargeStruct& v, size_t i) { v.key = (int64_t)i; }
+
+
+template <typename Deque>
+void bench(const string& name, const vector<size_t>& idx)
+{
+    typedef typename Deque::value_type T;
+    typedef chrono::steady_clock clock;
+
+    Deque d;
+    for (size_t i = 0; i < N; ++i) {
+        T v = T();
+        set_key(v, i);
+        d.push_back(v);
+    }
+
+    int64_t sum = 0;
+
+    /* d[i]: begin() + i, 一次段号/段内偏移的计算 */
+    clock::time_point t0 = clock::now();
+    for (size_t r = 0; r < ROUNDS; ++r) {
+        for (size_t i = 0; i < idx.size(); ++i) {
+            sum += key_of(d[idx[i]]);
+        }
+    }
+    clock::time_point t1 = clock::now();
+
+    /* 迭代器相加、相减 */
+    typename Deque::iterator first = d.begin();
+    for (size_t r = 0; r < ROUNDS; ++r) {
+        for (size_t i = 1; i < idx.size(); ++i) {
+            typename Deque::iterator it = first + (ptrdiff_t)idx[i];
+            it += (ptrdiff_t)idx[i - 1] - (ptrdiff_t)idx[i];
+            sum += it - first;
+        }
+    }
+    clock::time_point t2 = clock::now();
+
+    double access = chrono::duration<double, nano>(t1 - t0).count() / (ROUNDS * idx.size());
+    double arith = chrono::duration<double, nano>(t2 - t1).count() / (ROUNDS * idx.size());
+    cout << left << setw(36) << name
+         << " segment " << setw(5) << Deque::iterator::buffer_size()
+         << " random access " << fixed << setprecision(2) << setw(6) << access << " ns"
+         << "   iterator +/- " << setw(6) << arith << " ns"
+         << "   (" << sum << ")" << endl;
+}
+
+
+int main()
+{
+    vector<size_t> idx = make_indices(N);
+
+    /* 默认: 512 字节一段, 2 的幂个元素 */
+    bench<wkangk_stl::deque<int> >("deque<int>", idx);
+    /* 同样大小左右的段, 但不是 2 的幂, 只能做除法 */
+    bench<wkangk_stl::deque<int, wkangk_stl::alloc, 100> >("deque<int, 100>", idx);
+
+    bench<wkangk_stl::deque<LargeStruct> >("deque<LargeStruct>", idx);
+    bench<wkangk_stl::deque<LargeStruct, wkangk_stl::alloc, 6> >("deque<LargeStruct, 6>", idx);
+
+    return 0;
+}
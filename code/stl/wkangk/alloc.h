@@ -11,28 +11,66 @@ Copyright © wkangk <wangkangchn@163.com>
 
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <new>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 #include "config.h"
+#include "type_traits.h"
 
 
 __WKANGK_STL_BEGIN_NAMESPACE
 
 
-#include <iostream>
-#define __THROW_BAD_ALLOC   std::cerr << "out of memory" << std::endl; exit(1)
+/* 内存不足时抛出 std::bad_alloc, 由调用者决定是降级还是退出, 而不是直接 exit */
+#define __THROW_BAD_ALLOC   throw std::bad_alloc()
+
+/* 内存压力回调最多能注册的个数, 回调表是静态数组, 注册和调用都不需要分配内存 */
+enum { __MAX_PRESSURE_CALLBACKS = 16 };
 
 /* 
     第一级内存分配器, 分配大于 128B  的数据
+
+    malloc 失败后依次尝试:
+        1. 内存压力回调, 比如让缓存淘汰一部分数据, 有回调释放了内存就重试
+        2. 归还应急储备, 给 oom handler 以及后续的清理工作留一点余地
+        3. oom handler(set_malloc_handler), 没有设置就抛出 std::bad_alloc
+    try_allocate 走同样的流程, 只是最后返回 nullptr 而不抛出异常
  */
 template <int inst>    /* 这个泛型参数并没有啥用处 */
 class __malloc_alloc_template
 {
 public:
+    /**
+     *     内存压力回调
+     *
+     * @param [in]  bytes   正在申请的字节数
+     * @param [in]  ctx     注册时传入的参数
+     * @return     大致释放了多少字节, 返回 0 表示什么也没释放
+     */
+    typedef size_t (*pressure_callback)(size_t bytes, void* ctx);
+
     static void* allocate(size_t n) 
     {
         void* result = (void*)malloc(n);
         if (!result) {
-            result = oom_malloc(n);         /* 内存不足时, 重新分配 */
+            result = oom_malloc(n, false);         /* 内存不足时, 重新分配 */
+        }
+        return result;
+    }
+
+    /* 失败时返回 nullptr, 不抛出异常 */
+    static void* try_allocate(size_t n)
+    {
+        void* result = (void*)malloc(n);
+        if (!result) {
+            result = oom_malloc(n, true);
         }
         return result;
     }
@@ -42,6 +80,25 @@ public:
         free(p);
     }
 
+    /* 按 align 对齐分配, align 为 2 的幂. malloc 本身已经保证了 max_align_t 的对齐, 
+    再大的(如 alignas(64) 的类型)才需要 posix_memalign */
+    static void* allocate_aligned(size_t n, size_t align)
+    {
+        if (align <= alignof(max_align_t)) {
+            return allocate(n);
+        }
+        void* result = nullptr;
+        if (posix_memalign(&result, align, n) != 0) {
+            result = oom_malloc_aligned(n, align);
+        }
+        return result;
+    }
+
+    static void deallocate_aligned(void* p, size_t n, size_t align)
+    {
+        free(p);        /* posix_memalign 得到的内存也是 free 释放 */
+    }
+
     static void* reallocate(void* p, size_t new_sz)
     {
         void* result = realloc(p, new_sz);
@@ -51,6 +108,12 @@ public:
         return result;
     }
 
+    /* 与第二级配置器的接口保持一致 */
+    static void* reallocate(void* p, size_t old_sz, size_t new_sz)
+    {
+        return reallocate(p, new_sz);
+    }
+
     static void (* set_malloc_header(void(*f)()))()
     {
         void (*old)() = __malloc_alloc_omm_handler;
@@ -58,77 +121,356 @@ public:
         return old;
     }
 
+    /* 注册内存压力回调, 回调表满了返回 false. 回调可能在任意线程的分配路径上被调用 */
+    static bool add_pressure_callback(pressure_callback f, void* ctx)
+    {
+        std::lock_guard<std::mutex> guard(pressure_lock_);
+        for (size_t i = 0; i < __MAX_PRESSURE_CALLBACKS; ++i) {
+            if (!pressure_callbacks_[i].f) {
+                pressure_callbacks_[i].f = f;
+                pressure_callbacks_[i].ctx = ctx;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool remove_pressure_callback(pressure_callback f, void* ctx)
+    {
+        std::lock_guard<std::mutex> guard(pressure_lock_);
+        for (size_t i = 0; i < __MAX_PRESSURE_CALLBACKS; ++i) {
+            if (pressure_callbacks_[i].f == f && pressure_callbacks_[i].ctx == ctx) {
+                pressure_callbacks_[i].f = nullptr;
+                pressure_callbacks_[i].ctx = nullptr;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     *     预留 bytes 字节的应急储备, 内存耗尽时先把它还给系统, 再调用 oom handler.
+     * 储备只会归还一次, 之后需要再次调用本函数重新预留(比如在 handler 中降级完成之后).
+     * 传入 0 表示直接释放当前的储备.
+     *
+     * @return     预留失败返回 false
+     */
+    static bool set_emergency_reserve(size_t bytes)
+    {
+        void* block = bytes ? malloc(bytes) : nullptr;
+        if (bytes && !block) {
+            return false;
+        }
+        if (block) {
+            memset(block, 0, bytes);    /* 真正占住物理内存 */
+        }
+        free(emergency_reserve_.exchange(block));
+        return true;
+    }
+
+    /* 当前是否还持有应急储备 */
+    static bool has_emergency_reserve()
+    {
+        return emergency_reserve_.load() != nullptr;
+    }
+
 private:
-    static void* oom_malloc(size_t n)
+    /* 内存不足时的统一流程, retry 重新尝试一次分配 */
+    template <typename Retry>
+    static void* oom(Retry retry, size_t n, bool nothrow)
     {
         void (*my_malloc_handler)() = nullptr;
         void* result = nullptr;
 
         for (;;) {
+            if (run_pressure_callbacks(n) != 0 || release_emergency_reserve()) {
+                result = retry();
+                if (result) {
+                    return result;
+                }
+                continue;       /* 释放了一些但还不够, 再来一轮 */
+            }
+
             my_malloc_handler = __malloc_alloc_omm_handler;
             if (!my_malloc_handler) {
+                if (nothrow) {
+                    return nullptr;
+                }
                 __THROW_BAD_ALLOC;
             }
             (*my_malloc_handler)();     /* 内存不足时的回调函数 */
-            result = malloc(n);
+            result = retry();
             if (result) {
                 return result;
             }
         }
     }
 
+    static void* oom_malloc(size_t n, bool nothrow)
+    {
+        return oom([n]() { return malloc(n); }, n, nothrow);
+    }
+
+    static void* oom_malloc_aligned(size_t n, size_t align)
+    {
+        return oom([n, align]() {
+            void* result = nullptr;
+            return posix_memalign(&result, align, n) == 0 ? result : nullptr;
+        }, n, false);
+    }
+
     static void* oom_realloc(void* p, size_t new_sz)
     {
-        void (*my_malloc_handler)() = nullptr;
-        void* result = nullptr;
+        return oom([p, new_sz]() { return realloc(p, new_sz); }, new_sz, false);
+    }
 
-        for (;;) {
-            my_malloc_handler = __malloc_alloc_omm_handler;
-            if (!my_malloc_handler) {
-                __THROW_BAD_ALLOC;
-            }
-            (*my_malloc_handler)();     /* 内存不足时的回调函数 */
-            result = realloc(p, new_sz);
-            if (result) {
-                return result;
+    /* 依次调用所有回调, 返回总共释放的字节数. 回调表先拷贝到栈上, 调用时不持有锁,
+    回调中再分配内存也不会死锁 */
+    static size_t run_pressure_callbacks(size_t n)
+    {
+        pressure_entry callbacks[__MAX_PRESSURE_CALLBACKS];
+        {
+            std::lock_guard<std::mutex> guard(pressure_lock_);
+            memcpy(callbacks, pressure_callbacks_, sizeof(callbacks));
+        }
+
+        size_t freed = 0;
+        for (size_t i = 0; i < __MAX_PRESSURE_CALLBACKS; ++i) {
+            if (callbacks[i].f) {
+                freed += callbacks[i].f(n, callbacks[i].ctx);
             }
         }
+        return freed;
+    }
+
+    static bool release_emergency_reserve()
+    {
+        void* block = emergency_reserve_.exchange(nullptr);
+        free(block);
+        return block != nullptr;
     }
 
+    struct pressure_entry
+    {
+        pressure_callback f;
+        void* ctx;
+    };
+
     /* 函数指针 */
     static void (*__malloc_alloc_omm_handler)();
+
+    static pressure_entry pressure_callbacks_[__MAX_PRESSURE_CALLBACKS];
+    static std::mutex pressure_lock_;
+    static std::atomic<void*> emergency_reserve_;
 };
 
 template <int inst>
 void (*__malloc_alloc_template<inst>::__malloc_alloc_omm_handler)() = nullptr;
 
+template <int inst>
+typename __malloc_alloc_template<inst>::pressure_entry 
+__malloc_alloc_template<inst>::pressure_callbacks_[__MAX_PRESSURE_CALLBACKS] = {};
+
+template <int inst>
+std::mutex __malloc_alloc_template<inst>::pressure_lock_;
+
+template <int inst>
+std::atomic<void*> __malloc_alloc_template<inst>::emergency_reserve_(nullptr);
+
 
 typedef __malloc_alloc_template<0> malloc_alloc;
 
 
-/* 对 malloc_alloc 的简单封装, 使字节分配转为元素分配 */
-template <typename T, typename Alloc>
+enum { __ALIGN = 8 };         /* free list 中只保存 8 的倍数的内存块 */
+enum { __MAX_BYTES = 128 };   /* free list 中保存的最大内存的字节数*/
+enum { __NFREELISTS = __MAX_BYTES / __ALIGN }; /* free list 可以管理的内存块种类 */
+
+
+/**
+ *     对 malloc_alloc 的简单封装, 使字节分配转为元素分配
+ *     所有配置器的 allocate 至少保证 __ALIGN 对齐, Align 超过它时(如 alignas(64) 的类型)
+ * 改走 Alloc::allocate_aligned / deallocate_aligned, 所以容器按 alignof(T) 自动拿到
+ * 对齐的内存. 也可以显式给一个更大的 Align, 如 simple_alloc<int, alloc, 64>.
+ */
+template <typename T, typename Alloc, size_t Align = alignof(T)>
 class simple_alloc
 {
+    static_assert((Align & (Align - 1)) == 0, "Align must be a power of 2");
+
+    typedef typename __bool_type<(Align > __ALIGN)>::type over_aligned;
+
 public: 
     static T* allocate(size_t n)
     {
-        return n <= 0 ? 0 : (T*)Alloc::allocate(n * sizeof(T));
+        return n <= 0 ? 0 : (T*)allocate_aux(n * sizeof(T), over_aligned());
     }
     
     static T* allocate()
     {
-        return (T*)Alloc::allocate(sizeof(T));
+        return (T*)allocate_aux(sizeof(T), over_aligned());
     }
 
     static void deallocate(T* p, size_t n)
     {
-        Alloc::deallocate(p, n * sizeof(T));
+        deallocate_aux(p, n * sizeof(T), over_aligned());
     }
 
     static void deallocate(T* p)
     {
-        Alloc::deallocate(p, sizeof(T));
+        deallocate_aux(p, sizeof(T), over_aligned());
+    }
+
+private:
+    static void* allocate_aux(size_t bytes, __false_type)
+    {
+        return Alloc::allocate(bytes);
+    }
+
+    static void* allocate_aux(size_t bytes, __true_type)
+    {
+        return Alloc::allocate_aligned(bytes, Align);
+    }
+
+    static void deallocate_aux(T* p, size_t bytes, __false_type)
+    {
+        Alloc::deallocate(p, bytes);
+    }
+
+    static void deallocate_aux(T* p, size_t bytes, __true_type)
+    {
+        Alloc::deallocate_aligned(p, bytes, Align);
+    }
+};
+
+
+/**
+ *     配置器的特性, 与 __type_traits 一样默认采用最保守的答案, 由具体的配置器特化.
+ *
+ *     has_bulk_release    能否通过 reset() 一次性回收它分配出去的所有内存. 为真时
+ *                         节点容器 clear() 只需析构元素, 不必逐个归还节点
+ */
+template <typename Alloc>
+struct __alloc_traits
+{
+    typedef __false_type has_bulk_release;
+};
+
+
+/**
+ *     与 simple_alloc 相同, 把字节分配转为元素分配, 但是持有一个 Alloc 的实例, 
+ * 用于有状态的配置器, 比如每个分片各自一个内存池:
+ *
+ *     struct shard_alloc 
+ *     {
+ *         pool* p;
+ *         void* allocate(size_t bytes) { return p->allocate(bytes); }
+ *         void deallocate(void* ptr, size_t bytes) { p->deallocate(ptr, bytes); }
+ *     };
+ *
+ *     通过 static_cast<Alloc&>(*this).allocate() 调用, 所以 alloc 这种只有静态
+ * 成员的配置器也一样可以用. 
+ *     容器私有继承它, 无状态的配置器是空类, 空基类优化后不占容器的空间; 需要再绑定
+ * 到其他类型时(如 deque 的 map), 用 get_allocator() 临时构造一个即可.
+ */
+template <typename T, typename Alloc, size_t Align = alignof(T)>
+class __allocator : private Alloc
+{
+    static_assert((Align & (Align - 1)) == 0, "Align must be a power of 2");
+
+    typedef typename __bool_type<(Align > __ALIGN)>::type over_aligned;
+
+public:
+    typedef Alloc allocator_type;
+
+    __allocator() {}
+    __allocator(const Alloc& a) : Alloc(a) {}
+
+    T* allocate(size_t n)
+    {
+        return n <= 0 ? 0 : (T*)allocate_aux(n * sizeof(T), over_aligned());
+    }
+
+    T* allocate()
+    {
+        return (T*)allocate_aux(sizeof(T), over_aligned());
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        deallocate_aux(p, n * sizeof(T), over_aligned());
+    }
+
+    void deallocate(T* p)
+    {
+        deallocate_aux(p, sizeof(T), over_aligned());
+    }
+
+    /**
+     *     把 old_n 个元素的内存扩大/缩小到 new_n 个, 内容按字节搬过去, 只能用于可以平凡
+     * 搬迁的类型. 配置器有 reallocate(p, old_sz, new_sz) 时交给它(大块内存时就是 realloc,
+     * 可能原地扩展), 否则分配新内存再 memcpy. 超对齐的类型不能用 realloc.
+     *     失败时抛出 bad_alloc, p 保持不变.
+     */
+    T* reallocate(T* p, size_t old_n, size_t new_n)
+    {
+        if (!p) {
+            return allocate(new_n);
+        }
+        typedef decltype(can_reallocate(over_aligned(), has_reallocate((Alloc*)0))) use_reallocate;
+        return (T*)reallocate_aux(p, old_n * sizeof(T), new_n * sizeof(T), use_reallocate());
+    }
+
+    const Alloc& get_allocator() const 
+    {
+        return *this;
+    }
+
+    Alloc& get_allocator() 
+    {
+        return *this;
+    }
+
+private:
+    void* allocate_aux(size_t bytes, __false_type)
+    {
+        return static_cast<Alloc&>(*this).allocate(bytes);
+    }
+
+    void* allocate_aux(size_t bytes, __true_type)
+    {
+        return static_cast<Alloc&>(*this).allocate_aligned(bytes, Align);
+    }
+
+    void deallocate_aux(T* p, size_t bytes, __false_type)
+    {
+        static_cast<Alloc&>(*this).deallocate(p, bytes);
+    }
+
+    void deallocate_aux(T* p, size_t bytes, __true_type)
+    {
+        static_cast<Alloc&>(*this).deallocate_aligned(p, bytes, Align);
+    }
+
+    /* 检测 Alloc 是否提供 reallocate(p, old_sz, new_sz) */
+    template <typename A>
+    static auto has_reallocate(A* a) -> decltype(a->reallocate((void*)0, size_t(), size_t()), __true_type());
+    static __false_type has_reallocate(...);
+
+    static __true_type can_reallocate(__false_type, __true_type);
+    template <typename Aligned, typename HasReallocate>
+    static __false_type can_reallocate(Aligned, HasReallocate);
+
+    void* reallocate_aux(T* p, size_t old_bytes, size_t new_bytes, __true_type)
+    {
+        return static_cast<Alloc&>(*this).reallocate(p, old_bytes, new_bytes);
+    }
+
+    void* reallocate_aux(T* p, size_t old_bytes, size_t new_bytes, __false_type)
+    {
+        void* result = allocate_aux(new_bytes, over_aligned());
+        memcpy(result, p, old_bytes < new_bytes ? old_bytes : new_bytes);
+        deallocate_aux(p, old_bytes, over_aligned());
+        return result;
     }
 };
 
@@ -137,19 +479,268 @@ public:
  * 第二级配置器
  * ------------------------------------------------------------------------------- */
 
-enum { __ALIGN = 8 };         /* free list 中只保存 8 的倍数的内存块 */
-enum { __MAX_BYTES = 128 };   /* free list 中保存的最大内存的字节数*/
-enum { __NFREELISTS = __MAX_BYTES / __ALIGN }; /* free list 可以管理的内存块种类 */
+/* -------------------------------------------------------------------------------
+ * 内存块大小的划分策略
+ *
+ * 一个策略需要提供:
+ *      align               所有内存块都按它对齐
+ *      max_bytes           内存池管理的最大内存块, 更大的交给第一级配置器
+ *      nfreelists          内存块的种类数
+ *      index(bytes)        bytes 所属的种类
+ *      class_bytes(index)  某一种类的内存块大小
+ *      refill_objs(index, last)  refill 时一次切多少块, last 是这一种类上一次切的块数(第一次为 0)
+ * ------------------------------------------------------------------------------- */
 
+/* 原来的划分方式: 8 字节对齐, 最大 128 字节, 每次 refill 20 块 */
+struct __default_size_class
+{
+    enum { align = __ALIGN, max_bytes = __MAX_BYTES, nfreelists = __NFREELISTS };
 
-template <int inst>
+    static size_t index(size_t bytes)
+    {
+        return (bytes + align-1) / align - 1;
+    }
+
+    static size_t class_bytes(size_t index)
+    {
+        return (index + 1) * align;
+    }
+
+    static int refill_objs(size_t index, int last)
+    {
+        return 20;
+    }
+};
+
+
+inline constexpr size_t __static_log2(size_t n)
+{
+    return n <= 1 ? 0 : 1 + __static_log2(n / 2);
+}
+
+inline size_t __floor_log2(size_t n)
+{
+#if defined(__GNUC__)
+    return sizeof(size_t) * 8 - 1 - __builtin_clzl(n);
+#else
+    size_t result = 0;
+    while (n >>= 1) {
+        ++result;
+    }
+    return result;
+#endif
+}
+
+/**
+ *     LinearBytes 以内按 Align 线性划分; 再往上每翻一倍只划分 4 种, 如 128 之上是
+ * 160 192 224 256 320 384 448 512 ..., 这样 MaxBytes 放到 1 KiB 也只多了 12 条链,
+ * 浪费的空间不超过 25%.
+ *     refill 的块数随需求增长: 某一种类每 refill 一次, 下一次就切两倍的块数, 直到
+ * 一次切出约 64 KiB(至少 20 块, 至多 512 块).
+ *
+ * @param Align         对齐, 8/16/64 等 2 的幂
+ * @param MaxBytes      内存池管理的最大内存块
+ * @param LinearBytes   线性划分的上限, 要求至少是 4 * Align, 这样往上每一档的步长都是 Align 的倍数
+ */
+template <size_t Align = 16, size_t MaxBytes = 1024, size_t LinearBytes = 128>
+struct __geometric_size_class
+{
+    static_assert((Align & (Align - 1)) == 0 && Align >= sizeof(void*), "Align must be a power of 2 and hold a pointer");
+    static_assert(LinearBytes >= 4 * Align && (LinearBytes & (LinearBytes - 1)) == 0, "LinearBytes must be a power of 2 and >= 4 * Align");
+    static_assert(MaxBytes >= LinearBytes && (MaxBytes & (MaxBytes - 1)) == 0, "MaxBytes must be a power of 2 and >= LinearBytes");
+
+    enum { align = Align, max_bytes = MaxBytes };
+    enum { __LINEAR_CLASSES = LinearBytes / Align, __LINEAR_LOG2 = __static_log2(LinearBytes) };
+    enum { nfreelists = __LINEAR_CLASSES + 4 * (__static_log2(MaxBytes) - __LINEAR_LOG2) };
+
+    static size_t index(size_t bytes)
+    {
+        if (bytes <= LinearBytes) {
+            return (bytes + Align-1) / Align - 1;
+        }
+        /* bytes 在 (2^k, 2^(k+1)] 中, 这一段分为 4 档, 步长 2^k / 4 */
+        size_t k = __floor_log2(bytes - 1);
+        size_t step = (size_t(1) << k) >> 2;
+        size_t sub = (bytes - (size_t(1) << k) + step - 1) / step;     /* 1 ~ 4 */
+        return __LINEAR_CLASSES + 4 * (k - __LINEAR_LOG2) + sub - 1;
+    }
+
+    static size_t class_bytes(size_t index)
+    {
+        if (index < __LINEAR_CLASSES) {
+            return (index + 1) * Align;
+        }
+        size_t j = index - __LINEAR_CLASSES;
+        size_t base = size_t(1) << (__LINEAR_LOG2 + j / 4);
+        return base + (j % 4 + 1) * (base >> 2);
+    }
+
+    static int refill_objs(size_t index, int last)
+    {
+        const size_t limit = std::max<size_t>(20, std::min<size_t>(512, (64 << 10) / class_bytes(index)));
+        return last == 0 ? 20 : int(std::min<size_t>(limit, size_t(last) * 2));
+    }
+};
+
+
+/* -------------------------------------------------------------------------------
+ * 内存池向系统申请 chunk 的方式
+ *
+ * 一个 chunk 来源需要提供:
+ *      chunk_bytes(bytes)          实际申请的大小, 按来源的粒度向上取整, 多出来的部分内存池照样使用
+ *      allocate(bytes, align)      申请 bytes 字节, 至少按 align 对齐, 失败返回 nullptr
+ *      deallocate(p, bytes)        归还 allocate 得到的内存, bytes 与申请时相同
+ * ------------------------------------------------------------------------------- */
+
+/* 默认的来源, 与原来一样使用 malloc */
+struct __malloc_chunk_source
+{
+    static size_t chunk_bytes(size_t bytes)
+    {
+        return bytes;
+    }
+
+    /* align 超过 malloc 的保证时, chunk 本身也要对齐 */
+    static void* allocate(size_t bytes, size_t align)
+    {
+        if (align <= alignof(max_align_t)) {
+            return malloc(bytes);
+        }
+        void* result = nullptr;
+        return posix_memalign(&result, align, bytes) == 0 ? result : nullptr;
+    }
+
+    static void deallocate(void* p, size_t bytes)
+    {
+        free(p);
+    }
+};
+
+#ifdef __linux__
+/**
+ *     直接 mmap 匿名内存. 节点数量巨大的 hash_table/my_rb_tree 查找时 TLB 未命中
+ * 占了大头, 放到 2 MiB 的大页上可以大大减少 TLB 项.
+ *
+ * @param HugePage  chunk 按 2 MiB 对齐并取整, 再 madvise(MADV_HUGEPAGE) 请求透明大页.
+ *                  透明大页没有开启(/sys/kernel/mm/transparent_hugepage/enabled 为 never)
+ *                  时依然可以正常使用, 只是退化为普通页
+ * @param Populate  申请时就把所有页面都映射好(预先触发缺页), 缺页都发生在启动阶段,
+ *                  而不是在头几个请求中. 普通页直接使用 MAP_POPULATE; 大页要先 madvise 
+ *                  再触发缺页才能分到大页, 所以使用 MADV_POPULATE_WRITE, 内核不支持时
+ *                  逐页写一次
+ */
+template <bool HugePage = true, bool Populate = false>
+struct __mmap_chunk_source
+{
+    enum { __HUGE_PAGE_SIZE = 2 << 20 };
+
+    static size_t chunk_bytes(size_t bytes)
+    {
+        const size_t unit = granularity();
+        return (bytes + unit-1) & ~(unit-1);
+    }
+
+    static void* allocate(size_t bytes, size_t align)
+    {
+        const size_t page = page_size();
+        const size_t map_align = std::max(align, granularity());
+        const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+        char* result = nullptr;
+        if (map_align <= page) {
+            void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, 
+                           flags | (Populate && !HugePage ? MAP_POPULATE : 0), -1, 0);
+            if (p == MAP_FAILED) {
+                return nullptr;
+            }
+            result = (char*)p;
+        } else {
+            /* mmap 只保证页对齐, 多映射 map_align 字节, 再把头尾多余的部分还回去 */
+            void* p = mmap(nullptr, bytes + map_align, PROT_READ | PROT_WRITE, flags, -1, 0);
+            if (p == MAP_FAILED) {
+                return nullptr;
+            }
+            char* raw = (char*)p;
+            result = (char*)(((size_t)raw + map_align-1) & ~(map_align-1));
+            if (result != raw) {
+                munmap(raw, result - raw);
+            }
+            size_t tail = (raw + bytes + map_align) - (result + bytes);
+            if (tail != 0) {
+                munmap(result + bytes, tail);
+            }
+        }
+
+        if (HugePage) {
+#ifdef MADV_HUGEPAGE
+            madvise(result, bytes, MADV_HUGEPAGE);
+#endif
+            if (Populate) {
+                prefault(result, bytes);
+            }
+        }
+        return result;
+    }
+
+    static void deallocate(void* p, size_t bytes)
+    {
+        munmap(p, bytes);
+    }
+
+private:
+    static size_t page_size()
+    {
+        static const size_t size = (size_t)sysconf(_SC_PAGESIZE);
+        return size;
+    }
+
+    static size_t granularity()
+    {
+        return HugePage ? (size_t)__HUGE_PAGE_SIZE : page_size();
+    }
+
+    static void prefault(char* p, size_t bytes)
+    {
+#ifdef MADV_POPULATE_WRITE
+        if (madvise(p, bytes, MADV_POPULATE_WRITE) == 0) {
+            return;
+        }
+#endif
+        const size_t page = page_size();
+        for (size_t off = 0; off < bytes; off += page) {
+            ((volatile char*)p)[off] = 0;
+        }
+    }
+};
+#endif /* __linux__ */
+
+
+/* 统计开关, 定义 __WKANGK_STL_ALLOC_STATS 后才会统计各种计数, 否则计数代码不参与编译 */
+#ifdef __WKANGK_STL_ALLOC_STATS
+#define __ALLOC_STAT(stmt)  stmt
+#else
+#define __ALLOC_STAT(stmt)
+#endif
+
+
+/**
+ * @param inst          不同的 inst 是互不相干的两个内存池
+ * @param SizeClass     内存块大小的划分策略
+ * @param ChunkSource   向系统申请 chunk 的方式, 如大页上的内存池:
+ *                      __default_alloc_template<2, __default_size_class, __mmap_chunk_source<true, true> >
+ */
+template <int inst, typename SizeClass = __default_size_class, typename ChunkSource = __malloc_chunk_source>
 class __default_alloc_template
 {
 public:
+    typedef SizeClass size_class_type;
+    typedef ChunkSource chunk_source_type;
+
     static void* allocate(size_t bytes)
     {   
-        if (bytes > __MAX_BYTES) {         /* 大于最大交予第一级配置器 */
-            return malloc_alloc::allocate(bytes);
+        if (bytes > (size_t)SizeClass::max_bytes) {         /* 大于最大交予第一级配置器 */
+            __ALLOC_STAT(++large_allocs);
+            return malloc_alloc::allocate_aligned(bytes, SizeClass::align);
         }
 
         /* 找到申请内存块所属的 free_list 中的链, 链上有空余就返回
@@ -161,15 +752,21 @@ public:
             obj* result = *needed_free_list;
             /* 头结点下移, 因为这里是二级指针, 所以直接解引赋值, 修改的就直接是表头 */
             *needed_free_list = result->free_list_link;
+            in_use += ROUND_UP(bytes);
+            __ALLOC_STAT(++hits[FREELIST_INDEX(bytes)]);
             return (void*)result;
         }
 
-        return refill(ROUND_UP(bytes));
+        void* result = refill(ROUND_UP(bytes));
+        in_use += ROUND_UP(bytes);
+        __ALLOC_STAT(++misses[FREELIST_INDEX(bytes)]);
+        return result;
     }
 
     static void deallocate(void* p, size_t bytes)
     {
-        if (bytes > (size_t)__MAX_BYTES) {      /* 无论分配还是释放, 大于 __MAX_BYTES 就统统交由第一级管理器 */
+        if (bytes > (size_t)SizeClass::max_bytes) {      /* 无论分配还是释放, 大于 max_bytes 就统统交由第一级管理器 */
+            __ALLOC_STAT(++large_deallocs);
             malloc_alloc::deallocate(p, bytes);
             return;
         }
@@ -178,14 +775,99 @@ public:
         obj** needed_free_list = free_list + FREELIST_INDEX(bytes);
         ((obj*)p)->free_list_link = *needed_free_list; /* 头插 */
         *needed_free_list = (obj*)p;
+        in_use -= ROUND_UP(bytes);
+        __ALLOC_STAT(++deallocs[FREELIST_INDEX(bytes)]);
+        maybe_trim();
+    }
+
+    /**
+     *     从 bytes 所属的链上整段摘下最多 n 个内存块, 链空了先 refill. 摘下的块仍然
+     * 通过 free_list_link 串着, 最后一块指向 nullptr, 返回第一块, n 改为实际摘下的
+     * 个数(至少 1 个). bytes 不能超过 SizeClass::max_bytes.
+     *     给 __multi_client_alloc_template 与线程缓存成批交换用, 一次调用只遍历链表,
+     * 不逐块走 allocate
+     */
+    static void* allocate_batch(size_t bytes, size_t& n)
+    {
+        const size_t index = FREELIST_INDEX(bytes);
+        obj** needed_free_list = free_list + index;
+        __ALLOC_STAT(size_t refilled = 0);
+        if (!*needed_free_list) {
+            obj* first = (obj*)refill(ROUND_UP(bytes));     /* 其余的已经放到链上了 */
+            first->free_list_link = *needed_free_list;
+            *needed_free_list = first;
+            __ALLOC_STAT(refilled = 1);
+            __ALLOC_STAT(++misses[index]);
+        }
+
+        obj* head = *needed_free_list;
+        obj* tail = head;
+        size_t k = 1;
+        while (k < n && tail->free_list_link) {
+            tail = tail->free_list_link;
+            ++k;
+        }
+        *needed_free_list = tail->free_list_link;
+        tail->free_list_link = nullptr;
+        in_use += k * ROUND_UP(bytes);
+        __ALLOC_STAT(hits[index] += k - refilled);
+        n = k;
+        return (void*)head;
+    }
+
+    /* 把 head 到 tail 串好的 n 个内存块整段接回 bytes 所属的链上, 与 allocate_batch 对应 */
+    static void deallocate_batch(void* head, void* tail, size_t n, size_t bytes)
+    {
+        const size_t index = FREELIST_INDEX(bytes);
+        ((obj*)tail)->free_list_link = free_list[index];
+        free_list[index] = (obj*)head;
+        in_use -= n * ROUND_UP(bytes);
+        __ALLOC_STAT(deallocs[index] += n);
+        maybe_trim();
+    }
+
+    /* 失败时返回 nullptr, 不抛出异常. 内存池内部的各种失败最终都汇总为第一级配置器
+    抛出的 bad_alloc, 这里统一接住即可 */
+    static void* try_allocate(size_t bytes)
+    {
+        try {
+            return allocate(bytes);
+        } catch (const std::bad_alloc&) {
+            return nullptr;
+        }
+    }
+
+    /**
+     *     按 align 对齐分配. 内存池中的块只保证 SizeClass::align 对齐, 不超过它
+     * 就走内存池, 超过了交给第一级配置器. 需要内存池管理 64 字节对齐的小块时,
+     * 可以使用 __geometric_size_class<64, 1024, 256>.
+     */
+    static void* allocate_aligned(size_t bytes, size_t align)
+    {
+        if (align <= (size_t)SizeClass::align) {
+            return allocate(bytes);
+        }
+        __ALLOC_STAT(++large_allocs);
+        return malloc_alloc::allocate_aligned(bytes, align);
+    }
+
+    static void deallocate_aligned(void* p, size_t bytes, size_t align)
+    {
+        if (align <= (size_t)SizeClass::align) {
+            deallocate(p, bytes);
+            return;
+        }
+        __ALLOC_STAT(++large_deallocs);
+        malloc_alloc::deallocate_aligned(p, bytes, align);
     }
 
     /* 这个并没有做太多的处理 */
     static void* reallocate(void* p, size_t old_sz, size_t new_sz)
     {   
-        /* 都大于 __MAX_BYTES 就全部交由全局函数处理 */
-        if (old_sz > (size_t)__MAX_BYTES && new_sz > (size_t)__MAX_BYTES) {
-            return realloc(p, new_sz);
+        /* 都大于 max_bytes 就全部交由全局函数处理, realloc 不保证超过 max_align_t 的对齐 */
+        if (old_sz > (size_t)SizeClass::max_bytes && new_sz > (size_t)SizeClass::max_bytes
+            && SizeClass::align <= alignof(max_align_t)) {
+            return malloc_alloc::reallocate(p, new_sz);     /* 失败时同样走 oom 处理 */
         }
 
         if (ROUND_UP(old_sz) == ROUND_UP(new_sz)) {
@@ -201,7 +883,118 @@ public:
         return result;
     }
 
+    /**
+     *     将完全空闲的 chunk 还给系统, 直到空闲内存不超过 keep_bytes
+     *
+     * @param [in]  keep_bytes  希望保留的空闲字节数
+     * @return     还给系统的字节数
+     */
+    static size_t trim(size_t keep_bytes);
+
+    /* 将所有完全空闲的 chunk 都还给系统 */
+    static size_t release_unused()
+    {
+        return trim(0);
+    }
+
+    /**
+     *     设置空闲内存的水位线, 释放内存后空闲字节数超过水位线就自动 trim,
+     * 长期运行的服务在流量高峰过后可以缩回去. 0 表示不自动 trim(默认)
+     *
+     * @return     原先的水位线
+     */
+    static size_t set_high_water_mark(size_t bytes)
+    {
+        size_t old = high_water_mark;
+        high_water_mark = bytes;
+        trim_threshold = bytes;
+        return old;
+    }
+
+    /* 某一时刻分配器状态的快照 */
+    struct stats
+    {
+        /* 每种大小的内存块 */
+        struct size_class
+        {
+            size_t bytes;           /* 内存块大小 */
+            size_t free_blocks;     /* free_list 上现有的块数 */
+            size_t hits;            /* 直接从 free_list 上拿到的次数 */
+            size_t misses;          /* free_list 为空需要 refill 的次数 */
+            size_t deallocs;        /* 归还的次数 */
+        };
+
+        bool enabled;               /* 是否开启了计数统计, 没开启时计数全为 0 */
+        size_class classes[SizeClass::nfreelists];
+        size_t refill_calls;
+        size_t chunk_alloc_calls;
+        size_t large_allocs;        /* 交给第一级配置器的分配次数 */
+        size_t large_deallocs;
+        size_t chunks;              /* 现有 chunk 个数 */
+        size_t heap_bytes;          /* chunk 总字节数 */
+        size_t in_use_bytes;        /* 用户正在使用的字节数 */
+        size_t free_list_bytes;     /* free_list 上空闲的字节数 */
+        size_t pool_bytes;          /* 内存池中还未切分的字节数 */
+        size_t released_bytes;      /* trim 还给系统的总字节数 */
+
+        /* 空闲内存占比, 越大说明占着内存没用的越多 */
+        double fragmentation() const
+        {
+            return heap_bytes == 0 ? 0.0 : double(heap_bytes - in_use_bytes) / heap_bytes;
+        }
+
+        void dump(std::ostream& os) const
+        {
+            os << "heap: " << heap_bytes << "B in " << chunks << " chunks, in use: " << in_use_bytes
+               << "B, free list: " << free_list_bytes << "B, pool: " << pool_bytes 
+               << "B, released: " << released_bytes << "B, fragmentation: " << fragmentation() << "\n";
+            if (!enabled) {
+                os << "(counters disabled, define __WKANGK_STL_ALLOC_STATS to enable)\n";
+                return;
+            }
+            os << "refill: " << refill_calls << ", chunk_alloc: " << chunk_alloc_calls
+               << ", large alloc/dealloc: " << large_allocs << "/" << large_deallocs << "\n";
+            os << "bytes\tfree\thits\tmisses\tdeallocs\n";
+            for (size_t i = 0; i < SizeClass::nfreelists; ++i) {
+                const size_class& c = classes[i];
+                if (c.hits || c.misses || c.deallocs || c.free_blocks) {  /* 没用过的就不打印了 */
+                    os << c.bytes << "\t" << c.free_blocks << "\t" << c.hits << "\t" 
+                       << c.misses << "\t" << c.deallocs << "\n";
+                }
+            }
+        }
+    };
+
+    /* 获取一份快照, 需要遍历所有 free_list, 不要在热路径上调用 */
+    static stats get_stats();
+
 private:
+    /* 每一次从系统申请的一大块内存(chunk)头部都记录一个 chunk_header, 所有的
+    chunk 串成链表, trim 时才能知道哪些内存可以还回去 */
+    struct chunk_header
+    {
+        chunk_header* next;
+        size_t size;            /* chunk_header 之后可用的字节数 */
+        void (*release)(void*, size_t);     /* 归还时调用, 来源不同的 chunk 归还的方式不同 */
+    };
+    enum { __CHUNK_HEADER = (sizeof(chunk_header) + SizeClass::align-1) & ~(SizeClass::align-1) };
+
+    static char* chunk_data(chunk_header* chunk)
+    {
+        return (char*)chunk + __CHUNK_HEADER;
+    }
+
+    /* 将申请到的内存登记为 chunk, 返回可用区域的起始地址 */
+    static char* register_chunk(void* p, size_t bytes, void (*release)(void*, size_t))
+    {
+        chunk_header* chunk = (chunk_header*)p;
+        chunk->size = bytes;
+        chunk->release = release;
+        chunk->next = chunk_list;
+        chunk_list = chunk;
+        return chunk_data(chunk);
+    }
+
     /* 因为 union 共用的是同一块内存, 所以数据的地址
     也就是 obj 的地址 */
     union obj
@@ -212,12 +1005,12 @@ private:
     
 
     /**
-     *  将传入的大小, 向上对其到 __ALIGN 的倍数, 保证每次
-     * 申请的内存大小都是 8 的倍数
+     *  将传入的大小, 向上取到所属种类的内存块大小, 默认策略下
+     * 就是 8 的倍数
      */
     static size_t ROUND_UP(size_t bytes)
     {
-        return ((bytes + __ALIGN-1) & ~(__ALIGN-1));
+        return SizeClass::class_bytes(SizeClass::index(bytes));
     }
     
     /**
@@ -225,39 +1018,111 @@ private:
      */
     static size_t FREELIST_INDEX(size_t bytes) 
     {
-        return ((bytes + __ALIGN-1) / __ALIGN - 1); /* 最后 -1 是因为索引从 0 开始 */
+        return SizeClass::index(bytes);
+    }
+
+    /* 向上对齐到 align 的倍数 */
+    static size_t ALIGN_UP(size_t bytes)
+    {
+        return (bytes + SizeClass::align-1) & ~size_t(SizeClass::align-1);
     }
 
     static void* refill(size_t bytes);
     static char* chunk_alloc(size_t bytes, int& nobjs);
 
+    /* 空闲内存超过了水位线, 就尝试把整块空闲的 chunk 还给系统 */
+    static void maybe_trim()
+    {
+        if (high_water_mark && heap_size - in_use > trim_threshold) {
+            trim(high_water_mark);
+            trim_threshold = heap_size - in_use + high_water_mark;  /* 还不回去的是碎片, 
+                                                                    再多出一个水位线才重新尝试 */
+        }
+    }
+
 private:
     static char* start_free;
     static char* end_free;                  /* 内存池边界 */
-    static obj* free_list[__NFREELISTS];    /* 每一个代表了一种内存类型 */
-    static size_t heap_size;                /* 没理解这个要干嘛 */
+    static obj* free_list[SizeClass::nfreelists];    /* 每一个代表了一种内存类型 */
+    static size_t heap_size;                /* 从系统申请的总字节数, 用来让每次申请的 chunk 越来越大 */
+
+    static chunk_header* chunk_list;        /* 所有的 chunk */
+    static size_t in_use;                   /* 交给用户正在使用的字节数 */
+    static size_t high_water_mark;          /* 空闲内存的水位线 */
+    static size_t trim_threshold;           /* 空闲内存超过它才自动 trim */
+    static size_t released_bytes;           /* trim 还给系统的总字节数 */
+    static int refill_objs[SizeClass::nfreelists];   /* 每一种类上一次 refill 的块数 */
+
+#ifdef __WKANGK_STL_ALLOC_STATS
+    static size_t hits[SizeClass::nfreelists];
+    static size_t misses[SizeClass::nfreelists];
+    static size_t deallocs[SizeClass::nfreelists];
+    static size_t refill_calls;
+    static size_t chunk_alloc_calls;
+    static size_t large_allocs;
+    static size_t large_deallocs;
+#endif
 };
 
-template <int inst>
-char* __default_alloc_template<inst>::start_free = nullptr;
-template <int inst>
-char* __default_alloc_template<inst>::end_free = nullptr;
+template <int inst, typename SizeClass, typename ChunkSource>
+char* __default_alloc_template<inst, SizeClass, ChunkSource>::start_free = nullptr;
+template <int inst, typename SizeClass, typename ChunkSource>
+char* __default_alloc_template<inst, SizeClass, ChunkSource>::end_free = nullptr;
 
 /* 静态数组的初始化, 确实很新奇 */
-template <int inst>
-typename __default_alloc_template<inst>::obj* 
-__default_alloc_template<inst>::free_list[__NFREELISTS] = { nullptr };
+template <int inst, typename SizeClass, typename ChunkSource>
+typename __default_alloc_template<inst, SizeClass, ChunkSource>::obj* 
+__default_alloc_template<inst, SizeClass, ChunkSource>::free_list[SizeClass::nfreelists] = { nullptr };
 
-template <int inst>
-size_t __default_alloc_template<inst>::heap_size = 0;
+template <int inst, typename SizeClass, typename ChunkSource>
+size_t __default_alloc_template<inst, SizeClass, ChunkSource>::heap_size = 0;
+
+template <int inst, typename SizeClass, typename ChunkSource>
+typename __default_alloc_template<inst, SizeClass, ChunkSource>::chunk_header* 
+__default_alloc_template<inst, SizeClass, ChunkSource>::chunk_list = nullptr;
+
+template <int inst, typename SizeClass, typename ChunkSource>
+size_t __default_alloc_template<inst, SizeClass, ChunkSource>::in_use = 0;
+
+template <int inst, typename SizeClass, typename ChunkSource>
+size_t __default_alloc_template<inst, SizeClass, ChunkSource>::high_water_mark = 0;
+
+template <int inst, typename SizeClass, typename ChunkSource>
+size_t __default_alloc_template<inst, SizeClass, ChunkSource>::trim_threshold = 0;
+
+template <int inst, typename SizeClass, typename ChunkSource>
+size_t __default_alloc_template<inst, SizeClass, ChunkSource>::released_bytes = 0;
+
+template <int inst, typename SizeClass, typename ChunkSource>
+int __default_alloc_template<inst, SizeClass, ChunkSource>::refill_objs[SizeClass::nfreelists] = { 0 };
+
+#ifdef __WKANGK_STL_ALLOC_STATS
+template <int inst, typename SizeClass, typename ChunkSource>
+size_t __default_alloc_template<inst, SizeClass, ChunkSource>::hits[SizeClass::nfreelists] = { 0 };
+template <int inst, typename SizeClass, typename ChunkSource>
+size_t __default_alloc_template<inst, SizeClass, ChunkSource>::misses[SizeClass::nfreelists] = { 0 };
+template <int inst, typename SizeClass, typename ChunkSource>
+size_t __default_alloc_template<inst, SizeClass, ChunkSource>::deallocs[SizeClass::nfreelists] = { 0 };
+template <int inst, typename SizeClass, typename ChunkSource>
+size_t __default_alloc_template<inst, SizeClass, ChunkSource>::refill_calls = 0;
+template <int inst, typename SizeClass, typename ChunkSource>
+size_t __default_alloc_template<inst, SizeClass, ChunkSource>::chunk_alloc_calls = 0;
+template <int inst, typename SizeClass, typename ChunkSource>
+size_t __default_alloc_template<inst, SizeClass, ChunkSource>::large_allocs = 0;
+template <int inst, typename SizeClass, typename ChunkSource>
+size_t __default_alloc_template<inst, SizeClass, ChunkSource>::large_deallocs = 0;
+#endif
 
 /* 
     free_list 空了之后才会进行填充, 所以到这里的时候 free_list 已经没有数据了
-    从内存池中取出 20 个指定大小的内存块, 将其加入 free_list 中 */
-template <int inst>
-void* __default_alloc_template<inst>::refill(size_t bytes)
+    从内存池中取出 nobjs 个(默认 20 个)指定大小的内存块, 将其加入 free_list 中 */
+template <int inst, typename SizeClass, typename ChunkSource>
+void* __default_alloc_template<inst, SizeClass, ChunkSource>::refill(size_t bytes)
 {
-    int nobjs = 20;
+    size_t index = FREELIST_INDEX(bytes);
+    int nobjs = SizeClass::refill_objs(index, refill_objs[index]);
+    refill_objs[index] = nobjs;
+    __ALLOC_STAT(++refill_calls);
 
     /* chunk 会返回实际分配到的内存数目 */
     char* chunk = chunk_alloc(bytes, nobjs);
@@ -266,7 +1131,7 @@ void* __default_alloc_template<inst>::refill(size_t bytes)
     /* 多余一个的时候, 拿出第一个返回, 剩余的加入到 free_list 中
     只分配到一个, 就直接返回了, nobjs 不会 <= 0 */
     if (nobjs > 1) {
-        obj** needed_free_list = free_list + FREELIST_INDEX(bytes);
+        obj** needed_free_list = free_list + index;
 
         /* 每块申请得到的内存起始地址, 既做实际的内存地址, 也做链表
         地址, 这也可能是为什么申请字节最少是 8B 的原因, 因为 64 位机
@@ -275,20 +1140,22 @@ void* __default_alloc_template<inst>::refill(size_t bytes)
         了不起的设计   */
         *needed_free_list = (obj*)(chunk + bytes * 1);
         obj* current_obj = *needed_free_list;                           /* 这里 current_obj 应该是 nullptr */
-        for (size_t i = 2; i < nobjs; ++i) {
+        for (int i = 2; i < nobjs; ++i) {
             current_obj->free_list_link = (obj*)(chunk + bytes * i);    /* 0 被直接返回了 */
             current_obj = current_obj->free_list_link;
         }
-        current_obj = nullptr;    /* 推出循环后, current_obj 就是最后一个节点的 next, 需要赋值 nullptr  */
+        current_obj->free_list_link = nullptr;    /* 推出循环后, current_obj 就是最后一个节点, 它的 next 需要赋值 nullptr, 
+                                                    否则链尾是 malloc 出来的脏数据, trim 遍历链表时就会越界  */
     }
 
     return result;
 }
 
 
-template <int inst>
-char* __default_alloc_template<inst>::chunk_alloc(size_t bytes, int& nobjs)
+template <int inst, typename SizeClass, typename ChunkSource>
+char* __default_alloc_template<inst, SizeClass, ChunkSource>::chunk_alloc(size_t bytes, int& nobjs)
 {
+    __ALLOC_STAT(++chunk_alloc_calls);
     size_t total_bytes = bytes * nobjs;
     size_t bytes_left = end_free - start_free;      /* 内存池中剩余的空间 */
 
@@ -308,26 +1175,37 @@ char* __default_alloc_template<inst>::chunk_alloc(size_t bytes, int& nobjs)
 
     /* 一个元素都不能分配了, 但内存池中还有一些内存, 
     就将现在内存池中的内存添加到 free_list 中 */
-    if (bytes_left > 0) {
-        obj** needed_free_list = free_list + FREELIST_INDEX(bytes_left);
+    while (bytes_left > 0) {
+        /* 非线性划分时 bytes_left 不一定正好是某一种类的大小, 就放入不超过它的
+        最大种类, 剩下的再继续放, 一个字节都不丢, trim 统计空闲字节时才对得上 */
+        size_t index = FREELIST_INDEX(bytes_left);
+        if (SizeClass::class_bytes(index) > bytes_left) {
+            --index;
+        }
+        obj** needed_free_list = free_list + index;
         ((obj*)start_free)->free_list_link = *needed_free_list; /* 头插 */
         *needed_free_list = (obj*)start_free;
+        start_free += SizeClass::class_bytes(index);
+        bytes_left -= SizeClass::class_bytes(index);
     }
 
     /* 一切准备妥当了, 就再申请一大块内存 */
     /* heap_size 会逐渐增大, 不是很理解为何要这样处理 */
-    size_t bytes_to_get = 2 * total_bytes + ROUND_UP(heap_size >> 4);   
-    start_free = (char*)malloc(bytes_to_get);
+    size_t bytes_to_get = 2 * total_bytes + ALIGN_UP(heap_size >> 4);   
+    /* 按来源的粒度取整(如 mmap 的一页), 多出来的也一起放入内存池 */
+    bytes_to_get = ChunkSource::chunk_bytes(__CHUNK_HEADER + bytes_to_get) - __CHUNK_HEADER;
+    void* chunk = ChunkSource::allocate(__CHUNK_HEADER + bytes_to_get, SizeClass::align);
+    start_free = chunk ? register_chunk(chunk, bytes_to_get, &ChunkSource::deallocate) : nullptr;
     if (nullptr == start_free) {
         /* 堆上也没有了, 先看看 free_list 上有没有更大的内存区域还没用, 有的化就借来一用 */
         obj** needed_free_list = nullptr; 
-        for (size_t i = bytes; i < __MAX_BYTES; i += __ALIGN) {
-            needed_free_list = free_list + FREELIST_INDEX(i); 
+        for (size_t i = FREELIST_INDEX(bytes); i < SizeClass::nfreelists; ++i) {
+            needed_free_list = free_list + i; 
             
             if (*needed_free_list) {    
                 /* 剖离一个节点下来 */
                 start_free = (*needed_free_list)->client_data;
-                end_free = start_free + i;
+                end_free = start_free + SizeClass::class_bytes(i);
                 *needed_free_list = (*needed_free_list)->free_list_link;
                 return chunk_alloc(bytes, nobjs);   /* 递归的调用自己重新, 调整 nobjs */
             }
@@ -336,18 +1214,421 @@ char* __default_alloc_template<inst>::chunk_alloc(size_t bytes, int& nobjs)
         /* 彻底空了, 这时候看一看第一级配置器的 omm 机制能不能起到作用, 
         还是没有就会抛出异常 */
         end_free = nullptr; 
-        start_free = (char*)malloc_alloc::allocate(bytes_to_get);
+        start_free = register_chunk(malloc_alloc::allocate_aligned(__CHUNK_HEADER + bytes_to_get, SizeClass::align), 
+                                    bytes_to_get, &__malloc_chunk_source::deallocate);
     }
 
     end_free = start_free + bytes_to_get;
     heap_size += bytes_to_get;              /* heap 每次分配内存都会增加 */
+    trim_threshold = high_water_mark;       /* 又开始增长了, 水位线恢复 */
     return chunk_alloc(bytes, nobjs);       /* 取得新内存后, 重新调整 nobjs 的个数 */    
 }
 
 
-typedef __default_alloc_template<0> alloc; 
+/* 
+    统计每个 chunk 中空闲的字节数(free_list 上的节点 + 内存池中剩余的部分),
+    空闲字节数等于 chunk 大小的, 就说明整个 chunk 都没人用了, 可以还给系统 */
+template <int inst, typename SizeClass, typename ChunkSource>
+size_t __default_alloc_template<inst, SizeClass, ChunkSource>::trim(size_t keep_bytes)
+{
+    size_t nchunks = 0;
+    for (chunk_header* chunk = chunk_list; chunk; chunk = chunk->next) {
+        ++nchunks;
+    }
+    if (nchunks == 0 || heap_size - in_use <= keep_bytes) {
+        return 0;
+    }
+
+    /* 按地址排序后就可以二分查找一个节点属于哪个 chunk */
+    chunk_header** chunks = (chunk_header**)malloc(nchunks * sizeof(chunk_header*));
+    size_t* free_bytes = (size_t*)malloc(nchunks * sizeof(size_t));
+    if (!chunks || !free_bytes) {   /* 内存紧张就先不 trim 了 */
+        free(chunks);
+        free(free_bytes);
+        return 0;
+    }
+
+    size_t i = 0;
+    for (chunk_header* chunk = chunk_list; chunk; chunk = chunk->next) {
+        chunks[i] = chunk;
+        free_bytes[i] = 0;
+        ++i;
+    }
+    std::sort(chunks, chunks + nchunks);
+
+    /* 找到 p 所在的 chunk 的下标 */
+    auto chunk_index = [&](const char* p) -> size_t {
+        chunk_header** pos = std::upper_bound(chunks, chunks + nchunks, (chunk_header*)p);
+        return (pos - chunks) - 1;      /* 第一个起始地址大于 p 的前一个 */
+    };
+
+    if (end_free != start_free) {
+        free_bytes[chunk_index(start_free)] += end_free - start_free;
+    }
+    for (size_t n = 0; n < SizeClass::nfreelists; ++n) {
+        for (obj* cur = free_list[n]; cur; cur = cur->free_list_link) {
+            free_bytes[chunk_index(cur->client_data)] += SizeClass::class_bytes(n);
+        }
+    }
+
+    /* 决定要释放哪些 chunk, 这里复用 free_bytes, 置为 0 表示要释放 */
+    size_t idle = heap_size - in_use;
+    size_t released = 0;
+    for (i = 0; i < nchunks && idle > keep_bytes; ++i) {
+        if (free_bytes[i] == chunks[i]->size) {
+            idle -= chunks[i]->size;
+            released += chunks[i]->size;
+            free_bytes[i] = 0;
+        } else {
+            free_bytes[i] = 1;
+        }
+    }
+    for (; i < nchunks; ++i) {
+        free_bytes[i] = 1;
+    }
+
+    if (released != 0) {
+        /* 先把要释放的 chunk 中的节点从 free_list 上摘掉 */
+        for (size_t n = 0; n < SizeClass::nfreelists; ++n) {
+            obj** link = free_list + n;
+            while (*link) {
+                if (free_bytes[chunk_index((*link)->client_data)] == 0) {
+                    *link = (*link)->free_list_link;
+                } else {
+                    link = &(*link)->free_list_link;
+                }
+            }
+        }
+        if (end_free != start_free && free_bytes[chunk_index(start_free)] == 0) {
+            start_free = end_free = nullptr;
+        }
+
+        /* 再从 chunk 链表上摘掉并释放 */
+        chunk_header** link = &chunk_list;
+        while (*link) {
+            chunk_header* chunk = *link;
+            size_t n = std::lower_bound(chunks, chunks + nchunks, chunk) - chunks;
+            if (free_bytes[n] == 0) {
+                *link = chunk->next;
+                chunk->release(chunk, __CHUNK_HEADER + chunk->size);
+            } else {
+                link = &chunk->next;
+            }
+        }
+        heap_size -= released;
+        released_bytes += released;
+    }
+
+    free(chunks);
+    free(free_bytes);
+    return released;
+}
+
+
+template <int inst, typename SizeClass, typename ChunkSource>
+typename __default_alloc_template<inst, SizeClass, ChunkSource>::stats __default_alloc_template<inst, SizeClass, ChunkSource>::get_stats()
+{
+    stats result;
+    memset(&result, 0, sizeof(result));
+
+    for (chunk_header* chunk = chunk_list; chunk; chunk = chunk->next) {
+        ++result.chunks;
+    }
+    result.heap_bytes = heap_size;
+    result.in_use_bytes = in_use;
+    result.pool_bytes = end_free - start_free;
+    result.released_bytes = released_bytes;
+
+    for (size_t i = 0; i < SizeClass::nfreelists; ++i) {
+        typename stats::size_class& c = result.classes[i];
+        c.bytes = SizeClass::class_bytes(i);
+        for (obj* cur = free_list[i]; cur; cur = cur->free_list_link) {
+            ++c.free_blocks;
+        }
+        result.free_list_bytes += c.free_blocks * c.bytes;
+#ifdef __WKANGK_STL_ALLOC_STATS
+        c.hits = hits[i];
+        c.misses = misses[i];
+        c.deallocs = deallocs[i];
+#endif
+    }
+
+#ifdef __WKANGK_STL_ALLOC_STATS
+    result.enabled = true;
+    result.refill_calls = refill_calls;
+    result.chunk_alloc_calls = chunk_alloc_calls;
+    result.large_allocs = large_allocs;
+    result.large_deallocs = large_deallocs;
+#endif
+    return result;
+}
+
+
+/* -------------------------------------------------------------------------------
+ * 多线程配置器
+ * ------------------------------------------------------------------------------- */
+
+/**
+ *     __default_alloc_template 的 free_list/start_free/end_free 都是没有任何保护的
+ * 静态变量, 多个线程同时使用就会把内存池搞乱.
+ *     这里在它的前面再加一层: 每个线程持有一份自己的 free_list (thread cache),
+ * 分配/释放都先在自己的链表上进行, 完全不用加锁; 只有本线程的链表空了或者攒得
+ * 太多时, 才加锁与中心内存池(CentralAlloc)成批地交换内存块, 一次锁交换一批,
+ * 锁的开销就被摊薄了.
+ *
+ * @param CentralAlloc  中心内存池, 只会在持有 central_lock_ 时被访问, 需要提供
+ *                      allocate_batch/deallocate_batch 整段交换内存块
+ */
+template <typename CentralAlloc>
+class __multi_client_alloc_template
+{
+    typedef typename CentralAlloc::size_class_type size_class;
+
+public:
+    static void* allocate(size_t bytes)
+    {
+        if (bytes > (size_t)size_class::max_bytes) {      /* 大块内存直接交由 malloc, malloc 本身是线程安全的 */
+            return malloc_alloc::allocate_aligned(bytes, size_class::align);
+        }
+
+        thread_cache* cache = local_cache();
+        if (!cache) {   /* 线程正在退出, thread cache 已经析构了, 只能直接找中心池 */
+            std::lock_guard<std::recursive_mutex> guard(central_lock_);
+            return CentralAlloc::allocate(bytes);
+        }
+
+        /* 快速路径: 本线程链表上有就直接拿, 无锁 */
+        size_t index = FREELIST_INDEX(bytes);
+        obj* result = cache->free_list[index];
+        if (result) {
+            cache->free_list[index] = result->free_list_link;
+            --cache->count[index];
+            return (void*)result;
+        }
+
+        return refill(cache, index, ROUND_UP(bytes));
+    }
+
+    static void deallocate(void* p, size_t bytes)
+    {
+        if (bytes > (size_t)size_class::max_bytes) {
+            malloc_alloc::deallocate(p, bytes);
+            return;
+        }
+
+        thread_cache* cache = local_cache();
+        if (!cache) {
+            std::lock_guard<std::recursive_mutex> guard(central_lock_);
+            CentralAlloc::deallocate(p, bytes);
+            return;
+        }
+
+        /* 头插到本线程的链表 */
+        size_t index = FREELIST_INDEX(bytes);
+        ((obj*)p)->free_list_link = cache->free_list[index];
+        cache->free_list[index] = (obj*)p;
+
+        /* 攒得太多了, 就还一批给中心池, 避免一个线程分配, 另一个线程释放时,
+        内存全都堆积在释放线程里 */
+        if (++cache->count[index] > 2 * __BATCH_OBJS) {
+            release(cache, index, ROUND_UP(bytes), __BATCH_OBJS);
+        }
+    }
+
+    static void* try_allocate(size_t bytes)
+    {
+        try {
+            return allocate(bytes);
+        } catch (const std::bad_alloc&) {
+            return nullptr;
+        }
+    }
+
+    /* 与中心池相同, 不超过 size_class::align 的对齐走线程缓存 */
+    static void* allocate_aligned(size_t bytes, size_t align)
+    {
+        if (align <= (size_t)size_class::align) {
+            return allocate(bytes);
+        }
+        return malloc_alloc::allocate_aligned(bytes, align);
+    }
+
+    static void deallocate_aligned(void* p, size_t bytes, size_t align)
+    {
+        if (align <= (size_t)size_class::align) {
+            deallocate(p, bytes);
+            return;
+        }
+        malloc_alloc::deallocate_aligned(p, bytes, align);
+    }
+
+    static void* reallocate(void* p, size_t old_sz, size_t new_sz)
+    {
+        if (old_sz > (size_t)size_class::max_bytes && new_sz > (size_t)size_class::max_bytes
+            && size_class::align <= alignof(max_align_t)) {
+            return malloc_alloc::reallocate(p, new_sz);
+        }
+
+        if (ROUND_UP(old_sz) == ROUND_UP(new_sz)) {
+            return p;
+        }
+
+        void* result = allocate(new_sz);
+        size_t copy_sz = old_sz <= new_sz ? old_sz : new_sz;
+        memcpy(result, p, copy_sz);
+        deallocate(p, old_sz);
+        return result;
+    }
+
+    /* 将本线程缓存的内存块全部还给中心池 */
+    static void flush_thread_cache()
+    {
+        thread_cache* cache = local_cache();
+        if (cache) {
+            cache->flush();
+        }
+    }
+
+    /* 其它线程缓存着的内存块会让所在的 chunk 还不回去, 这里只能先还掉本线程的 */
+    static size_t trim(size_t keep_bytes)
+    {
+        flush_thread_cache();
+        std::lock_guard<std::recursive_mutex> guard(central_lock_);
+        return CentralAlloc::trim(keep_bytes);
+    }
+
+    static size_t release_unused()
+    {
+        return trim(0);
+    }
+
+    static size_t set_high_water_mark(size_t bytes)
+    {
+        std::lock_guard<std::recursive_mutex> guard(central_lock_);
+        return CentralAlloc::set_high_water_mark(bytes);
+    }
+
+    /* 中心池的快照, 各线程缓存着的内存块算作中心池的 in use */
+    static typename CentralAlloc::stats get_stats()
+    {
+        std::lock_guard<std::recursive_mutex> guard(central_lock_);
+        return CentralAlloc::get_stats();
+    }
+
+private:
+    enum { __BATCH_OBJS = 32 };     /* 与中心池一次交换的内存块个数 */
+
+    union obj
+    {
+        union obj* free_list_link;
+        char client_data[1];
+    };
+
+    /* 每个线程一份的 free_list */
+    struct thread_cache
+    {
+        thread_cache()
+        {
+            for (size_t i = 0; i < size_class::nfreelists; ++i) {
+                free_list[i] = nullptr;
+                count[i] = 0;
+            }
+        }
+
+        /* 线程退出时把手里的内存全部还回去, 不然就泄漏了 */
+        ~thread_cache()
+        {
+            cache_dead_ = true;
+            flush();
+        }
+
+        void flush()
+        {
+            for (size_t i = 0; i < size_class::nfreelists; ++i) {
+                if (count[i] != 0) {
+                    release(this, i, size_class::class_bytes(i), count[i]);
+                }
+            }
+        }
+
+        obj* free_list[size_class::nfreelists];
+        size_t count[size_class::nfreelists];     /* 每条链上的节点个数, 用来判断何时归还 */
+    };
+
+    static size_t ROUND_UP(size_t bytes)
+    {
+        return size_class::class_bytes(size_class::index(bytes));
+    }
+
+    static size_t FREELIST_INDEX(size_t bytes)
+    {
+        return size_class::index(bytes);
+    }
+
+    static thread_cache* local_cache()
+    {
+        /* thread_local 对象析构之后, 同一线程中其它 thread_local 对象的析构函数
+        仍可能释放内存, 这时就不能再碰 cache 了 */
+        if (cache_dead_) {
+            return nullptr;
+        }
+        static thread_local thread_cache cache;
+        return &cache;
+    }
+
+    /* 本线程链表空了, 从中心池的链上整段摘一批回来, 第一个直接返回 */
+    static void* refill(thread_cache* cache, size_t index, size_t bytes)
+    {
+        size_t n = __BATCH_OBJS;
+        obj* head;
+        {
+            std::lock_guard<std::recursive_mutex> guard(central_lock_);
+            head = (obj*)CentralAlloc::allocate_batch(bytes, n);   /* 中心池也不够时可能少于一批 */
+        }
+
+        cache->free_list[index] = head->free_list_link;
+        cache->count[index] = n - 1;
+        return (void*)head;
+    }
+
+    /* 从本线程链表摘下 n 个节点, 加锁后整段接到中心池的链上 */
+    static void release(thread_cache* cache, size_t index, size_t bytes, size_t n)
+    {
+        obj* head = cache->free_list[index];
+        obj* tail = head;
+        for (size_t i = 1; i < n; ++i) {    /* 摘链在锁外完成 */
+            tail = tail->free_list_link;
+        }
+        cache->free_list[index] = tail->free_list_link;
+        cache->count[index] -= n;
+        tail->free_list_link = nullptr;
+
+        std::lock_guard<std::recursive_mutex> guard(central_lock_);
+        CentralAlloc::deallocate_batch(head, tail, n, bytes);
+    }
+
+private:
+    static std::recursive_mutex central_lock_;  /* 保护中心池, 内存压力回调中可能再次调用 trim, 所以可重入 */
+    static thread_local bool cache_dead_;       /* 本线程的 thread cache 是否已经析构 */
+};
+
+template <typename CentralAlloc>
+std::recursive_mutex __multi_client_alloc_template<CentralAlloc>::central_lock_;
+
+template <typename CentralAlloc>
+thread_local bool __multi_client_alloc_template<CentralAlloc>::cache_dead_ = false;
+
+
+/* 中心池使用单独的实例, 不与单线程的 alloc 共用静态成员 */
+typedef __multi_client_alloc_template<__default_alloc_template<1> > multi_client_alloc;
 typedef __default_alloc_template<0> single_client_alloc; 
 
+#ifdef __WKANGK_STL_THREADS
+typedef multi_client_alloc alloc;
+#else
+typedef __default_alloc_template<0> alloc; 
+#endif
+
 __WKANGK_STL_END_NAMESPACE
 
 #endif	/* !__WKANGK_STL_ALLOC_H__ */
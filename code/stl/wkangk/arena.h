@@ -0,0 +1,351 @@
+/***************************************************************
+ * @copyright  Copyright © 2026 wkangk.
+ * @file       arena.h
+ * @author     wkangk <wangkangchn@163.com>
+ * @version    v1.0
+ * @brief      单调增长的内存竞技场(bump allocator)
+ * @date       2026-10-16 14:10
+ **************************************************************/
+#ifndef __WKANGK_STL_ARENA_H__
+#define __WKANGK_STL_ARENA_H__
+#include "alloc.h"
+#include "debug.h"
+
+__WKANGK_STL_BEGIN_NAMESPACE
+
+/* -------------------------------------------------------------------------------
+ *     arena 只管往前切内存, 从不回收单个内存块, 析构或 release() 时一次性全部归还.
+ * 适合生命周期一致的一批对象, 比如一次请求中用到的 map/list, 请求结束时整体丢弃,
+ * 中间没有一次 free.
+ *
+ *     内存以 block 为单位向第一级配置器申请, 每个 block 头部记录链表指针和大小,
+ * 新 block 的大小按两倍增长(类似 vector), 超大的请求单独占一个 block.
+ * 也可以给一块初始缓冲区(比如栈上的数组), 用完了才去申请 block.
+ *
+ *     arena 本身不是线程安全的, 一个 arena 只能在一个线程中使用.
+ * ------------------------------------------------------------------------------- */
+class arena
+{
+public:
+    explicit arena(size_t block_size = 4096)
+        : blocks_(nullptr), cur_(nullptr), end_(nullptr),
+          initial_buffer_(nullptr), initial_size_(0),
+          initial_block_size_(block_size), next_block_size_(block_size),
+          bytes_allocated_(0)
+    {
+    }
+
+    /* buffer 由调用者持有, arena 不会释放它 */
+    arena(void* buffer, size_t bytes, size_t block_size = 4096)
+        : blocks_(nullptr), cur_((char*)buffer), end_((char*)buffer + bytes),
+          initial_buffer_((char*)buffer), initial_size_(bytes),
+          initial_block_size_(block_size), next_block_size_(block_size),
+          bytes_allocated_(0)
+    {
+    }
+
+    ~arena()
+    {
+        release();
+    }
+
+    /* 按 align 对齐切出 bytes 字节, align 为 2 的幂 */
+    void* allocate(size_t bytes, size_t align = __ALIGN)
+    {
+        char* result = align_up(cur_, align);
+        if (!cur_ || result + bytes > end_) {
+            new_block(bytes, align);
+            result = align_up(cur_, align);
+        }
+        cur_ = result + bytes;
+        bytes_allocated_ += bytes;
+        return result;
+    }
+
+    /* 单个内存块不回收, 什么也不做 */
+    void deallocate(void* p, size_t bytes)
+    {
+    }
+
+    /* 把所有 block 还给系统, 回到刚构造完的状态, 之前分配的内存全部失效 */
+    void release()
+    {
+        while (blocks_) {
+            block* next = blocks_->next;
+            malloc_alloc::deallocate(blocks_, blocks_->size);
+            blocks_ = next;
+        }
+        cur_ = initial_buffer_;
+        end_ = initial_buffer_ + initial_size_;
+        next_block_size_ = initial_block_size_;
+        bytes_allocated_ = 0;
+    }
+
+    /* p 是否落在初始缓冲区或某个 block 中, 即是否由这个 arena 切出 */
+    bool owns(const void* p) const
+    {
+        const char* c = (const char*)p;
+        if (initial_buffer_ && c >= initial_buffer_ && c < initial_buffer_ + initial_size_) {
+            return true;
+        }
+        for (block* cur = blocks_; cur; cur = cur->next) {
+            if (c >= (const char*)(cur + 1) && c < (const char*)cur + cur->size) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /* 已经切出去的字节数 */
+    size_t bytes_allocated() const
+    {
+        return bytes_allocated_;
+    }
+
+    /* 向系统申请的字节数, 不含初始缓冲区 */
+    size_t bytes_reserved() const
+    {
+        size_t result = 0;
+        for (block* cur = blocks_; cur; cur = cur->next) {
+            result += cur->size;
+        }
+        return result;
+    }
+
+private:
+    arena(const arena&);
+    arena& operator=(const arena&);
+
+    struct block
+    {
+        block* next;
+        size_t size;        /* 包括 block 头在内的整个 block 的大小 */
+    };
+
+    static char* align_up(char* p, size_t align)
+    {
+        return (char*)(((size_t)p + align-1) & ~(align-1));
+    }
+
+    void new_block(size_t bytes, size_t align)
+    {
+        /* 最坏情况下对齐要浪费 align-1 个字节 */
+        size_t need = sizeof(block) + bytes + align-1;
+        size_t block_size = std::max(next_block_size_, need);
+        block* new_one = (block*)malloc_alloc::allocate(block_size);
+        new_one->next = blocks_;
+        new_one->size = block_size;
+        blocks_ = new_one;
+        cur_ = (char*)(new_one + 1);
+        end_ = (char*)new_one + block_size;
+        next_block_size_ *= 2;
+    }
+
+private:
+    block* blocks_;                 /* 所有申请过的 block, 头插 */
+    char* cur_;                     /* 当前 block 中空闲部分的起点 */
+    char* end_;                     /* 当前 block 的终点 */
+    char* initial_buffer_;
+    size_t initial_size_;
+    size_t initial_block_size_;
+    size_t next_block_size_;
+    size_t bytes_allocated_;
+};
+
+
+/* -------------------------------------------------------------------------------
+ *     有状态的配置器, 持有一个 arena 的指针, 同一类型的两个容器可以各自使用不同的
+ * arena, 比如每个分片/租户一个:
+ *
+ *     arena shard0, shard1;
+ *     hash_map<int, int, hash<int>, equal_to<int>, arena_ref> m0(100, hash<int>(), equal_to<int>(), arena_ref(shard0));
+ *     hash_map<int, int, hash<int>, equal_to<int>, arena_ref> m1(100, hash<int>(), equal_to<int>(), arena_ref(shard1));
+ *
+ *     拷贝/交换容器时 arena_ref 跟着一起拷贝/交换, arena 要比使用它的容器活得久.
+ * ------------------------------------------------------------------------------- */
+class arena_ref
+{
+public:
+    arena_ref() : arena_(nullptr) {}
+    arena_ref(arena& a) : arena_(&a) {}
+
+    void* allocate(size_t bytes)
+    {
+        return arena_->allocate(bytes);
+    }
+
+    void deallocate(void* p, size_t bytes)
+    {
+    }
+
+    void* allocate_aligned(size_t bytes, size_t align)
+    {
+        return arena_->allocate(bytes, align);
+    }
+
+    void deallocate_aligned(void* p, size_t bytes, size_t align)
+    {
+    }
+
+    arena* get_arena() const
+    {
+        return arena_;
+    }
+
+    bool operator==(const arena_ref& x) const { return arena_ == x.arena_; }
+    bool operator!=(const arena_ref& x) const { return arena_ != x.arena_; }
+
+private:
+    arena* arena_;
+};
+
+
+template <int inst> class __scoped_arena_template;
+
+/* -------------------------------------------------------------------------------
+ *     与 alloc/malloc_alloc 一样只有静态的 allocate/deallocate, 可以直接作为容器的
+ * Alloc 参数. 内存来自当前线程中最内层的 scoped_arena, deallocate 什么也不做.
+ * 使用了它的容器必须在 scoped_arena 结束之前销毁.
+ *
+ *     容器不记录创建时的 arena, 每次分配都取分配那一刻最内层的 scoped_arena. 在外层
+ * scope 中建好的 map 如果在内层 scope 中插入, 新节点来自内层的 arena, 内层结束后就
+ * 悬空了. 所以一个容器的所有插入/扩容都要在同一个 scoped_arena 生效时进行; 做不到
+ * 时改用 arena_ref, 构造时就把 arena 固定下来.
+ *     定义 __WKANGK_STL_DEBUG 后, deallocate/reallocate 检查归还的内存是否来自当前
+ * 的 arena, 能查出在别的 scope 中扩容(vector 扩容时归还旧缓冲区)或者释放的情况;
+ * 只插入不归还的情况查不出来.
+ *
+ *     不同的 inst 各自有一套 scoped_arena, 互不影响.
+ * ------------------------------------------------------------------------------- */
+template <int inst>
+class __arena_alloc_template
+{
+    friend class __scoped_arena_template<inst>;
+
+public:
+    static void* allocate(size_t bytes)
+    {
+        return current()->allocate(bytes);
+    }
+
+    static void deallocate(void* p, size_t bytes)
+    {
+        check_current(p);
+    }
+
+    static void* allocate_aligned(size_t bytes, size_t align)
+    {
+        return current()->allocate(bytes, align);
+    }
+
+    static void deallocate_aligned(void* p, size_t bytes, size_t align)
+    {
+        check_current(p);
+    }
+
+    static void* reallocate(void* p, size_t old_sz, size_t new_sz)
+    {
+        check_current(p);
+        if (new_sz <= old_sz) {
+            return p;
+        }
+        void* result = allocate(new_sz);
+        memcpy(result, p, old_sz);
+        return result;
+    }
+
+    /* 当前生效的 arena, 没有时为 nullptr */
+    static arena* active_arena()
+    {
+        return current_;
+    }
+
+private:
+    static arena* current()
+    {
+        if (!current_) {
+            std::cerr << "arena_alloc: no scoped_arena is active" << std::endl;
+            abort();
+        }
+        return current_;
+    }
+
+    /* 调试模式下检查归还的内存来自当前的 arena */
+    static void check_current(const void* p)
+    {
+        __STL_DEBUG_CHECK(!p || current()->owns(p),
+                          "arena_alloc: memory returned under a different scoped_arena than it came from");
+    }
+
+    static thread_local arena* current_;
+};
+
+template <int inst>
+thread_local arena* __arena_alloc_template<inst>::current_ = nullptr;
+
+
+/* -------------------------------------------------------------------------------
+ *     RAII: 构造时把 arena 设为当前线程 __arena_alloc_template<inst> 的内存来源,
+ * 析构时恢复之前的 arena, 所以可以嵌套.
+ *     不传 arena 时使用自己持有的 arena, 析构时一并释放; 传入外部的 arena 时只负责
+ * 切换, 释放由 arena 的所有者负责.
+ *     arena_alloc 的容器不会记住自己的 arena, 嵌套时不能在内层 scope 中向外层建好的
+ * 容器插入元素(见 __arena_alloc_template), 需要跨 scope 的容器用 arena_ref.
+ *
+ *     {
+ *         scoped_arena scope;
+ *         map<int, int, less<int>, arena_alloc> m;
+ *         ...
+ *     }   // m 先析构(不调用 free), 然后 scope 一次性释放全部内存
+ * ------------------------------------------------------------------------------- */
+template <int inst>
+class __scoped_arena_template
+{
+    typedef __arena_alloc_template<inst> arena_alloc_type;
+
+public:
+    explicit __scoped_arena_template(size_t block_size = 4096)
+        : own_(block_size), arena_(&own_), previous_(arena_alloc_type::current_)
+    {
+        arena_alloc_type::current_ = arena_;
+    }
+
+    __scoped_arena_template(void* buffer, size_t bytes, size_t block_size = 4096)
+        : own_(buffer, bytes, block_size), arena_(&own_), previous_(arena_alloc_type::current_)
+    {
+        arena_alloc_type::current_ = arena_;
+    }
+
+    explicit __scoped_arena_template(arena& a)
+        : own_(0), arena_(&a), previous_(arena_alloc_type::current_)
+    {
+        arena_alloc_type::current_ = arena_;
+    }
+
+    ~__scoped_arena_template()
+    {
+        arena_alloc_type::current_ = previous_;
+    }
+
+    arena& get_arena()
+    {
+        return *arena_;
+    }
+
+private:
+    __scoped_arena_template(const __scoped_arena_template&);
+    __scoped_arena_template& operator=(const __scoped_arena_template&);
+
+private:
+    arena own_;
+    arena* arena_;
+    arena* previous_;
+};
+
+
+typedef __arena_alloc_template<0> arena_alloc;
+typedef __scoped_arena_template<0> scoped_arena;
+
+__WKANGK_STL_END_NAMESPACE
+
+#endif	/* !__WKANGK_STL_ARENA_H__ */
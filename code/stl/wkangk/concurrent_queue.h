@@ -0,0 +1,282 @@
+/***************************************************************
+ * @copyright  Copyright © 2026 wkangk.
+ * @file       concurrent_queue.h
+ * @author     wkangk <wangkangchn@163.com>
+ * @version    v1.0
+ * @brief      无锁的无界队列, 由 deque 那样的定长段串成
+ * @date       2026-10-16 23:20
+ **************************************************************/
+#ifndef __WKANGK_STL_CONCURRENT_QUEUE_H__
+#define __WKANGK_STL_CONCURRENT_QUEUE_H__
+#include <stddef.h>
+#include <atomic>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "config.h"
+#include "alloc.h"
+#include "construct.h"
+#include "deque.h"
+#include "hazard_pointer.h"
+
+__WKANGK_STL_BEGIN_NAMESPACE
+
+/**
+ *     多生产者多消费者的无界队列. 与 ring_queue 不同, 容量不固定, 突发的大量 push
+ * 不会失败也不会阻塞生产者.
+ *
+ *     元素放在一段一段的数组中, 段的大小与 deque 相同(__deque_buf_size<T, BufSiz>),
+ * 段之间用 next 串成单链表, head_ 指向最老的段, tail_ 指向最新的段:
+ *      - 生产者对 tail_ 段的 enq_idx 原子加一领到一个槽, 写入后把槽标为 READY;
+ *        领到的下标超出段长时挂上新段
+ *      - 消费者对 head_ 段的 deq_idx 原子加一领到一个槽, 取走数据; 段取完后
+ *        head_ 前进, 旧段交给危险指针回收, 其他线程还在访问时不会被释放
+ *      - 消费者领到的槽还没写入(生产者慢了)时, 等一小会儿后把槽作废, 生产者
+ *        发现槽作废了就把元素拿回来重新领一个槽, 谁都不会一直等下去
+ *
+ *     接口与 queue 相同的部分是 push/emplace/empty; 多线程下 front/back 没有意义,
+ * pop 改为 try_pop(v), 队列空时返回 false.
+ *     重新领槽时元素要移动, 所以要求 T 的移动构造/移动赋值不抛异常. 段在多个线程中
+ * 分配, 又要在危险指针的回收函数中释放, 所以 Alloc 要线程安全并且只有静态成员,
+ * 默认用 malloc_alloc.
+ *
+ * @param T         元素类型
+ * @param Alloc     分配段的配置器
+ * @param BufSiz    每段的元素个数, 0 表示与 deque<T> 相同
+ */
+template <typename T, typename Alloc = malloc_alloc, size_t BufSiz = 0>
+class concurrent_queue
+{
+    static_assert(std::is_nothrow_move_constructible<T>::value,
+                  "concurrent_queue requires a noexcept move constructor");
+    static_assert(std::is_nothrow_move_assignable<T>::value,
+                  "concurrent_queue requires a noexcept move assignment");
+
+    enum { __SEGMENT_SIZE = __deque_buf_size<T, BufSiz>::value };
+    enum { __EMPTY = 0, __READY = 1, __ABANDONED = 2 };     /* 槽的状态 */
+    enum { __SPIN = 256 };      /* 消费者作废一个槽之前等待的次数 */
+    enum { __HP_SEGMENT = 0 };  /* 保护当前访问的段的危险指针 */
+
+    struct slot
+    {
+        std::atomic<unsigned char> state;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        T* ptr() { return reinterpret_cast<T*>(&storage); }
+    };
+
+    struct segment
+    {
+        std::atomic<size_t> enq_idx;
+        char pad0[__WKANGK_STL_CACHE_LINE - sizeof(std::atomic<size_t>)];
+        std::atomic<size_t> deq_idx;
+        char pad1[__WKANGK_STL_CACHE_LINE - sizeof(std::atomic<size_t>)];
+        std::atomic<segment*> next;
+        slot slots[__SEGMENT_SIZE];
+
+        segment() : enq_idx(0), deq_idx(0), next(nullptr)
+        {
+            for (size_t i = 0; i < __SEGMENT_SIZE; ++i) {
+                slots[i].state.store(__EMPTY, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    typedef simple_alloc<segment, Alloc> segment_allocator;
+
+public:
+    typedef T           value_type;
+    typedef size_t      size_type;
+    typedef Alloc       allocator_type;
+
+public:
+    concurrent_queue()
+    {
+        segment* s = new_segment();
+        head_.store(s);
+        tail_.store(s);
+    }
+
+    /* 析构时不能再有其他线程访问队列 */
+    ~concurrent_queue()
+    {
+        segment* s = head_.load();
+        while (s) {
+            size_t end = std::min<size_t>(s->enq_idx.load(), __SEGMENT_SIZE);
+            for (size_t i = std::min<size_t>(s->deq_idx.load(), __SEGMENT_SIZE); i < end; ++i) {
+                if (s->slots[i].state.load() == __READY) {
+                    destroy(s->slots[i].ptr());
+                }
+            }
+            segment* next = s->next.load();
+            delete_segment(s);
+            s = next;
+        }
+    }
+
+    static constexpr size_type segment_size()
+    {
+        return __SEGMENT_SIZE;
+    }
+
+    void push(const value_type& v)
+    {
+        value_type tmp(v);      /* 拷贝可能抛异常, 在领槽之前完成 */
+        push(std::move(tmp));
+    }
+
+    void push(value_type&& v)
+    {
+        for (;;) {
+            segment* s = __hazard_domain::protect(__HP_SEGMENT, tail_);
+            size_t idx = s->enq_idx.fetch_add(1, std::memory_order_acq_rel);
+            if (idx >= __SEGMENT_SIZE) {
+                /* 段满了, 挂上新段(或者帮别人推进 tail_)后重来 */
+                append_segment(s);
+                continue;
+            }
+
+            slot& sl = s->slots[idx];
+            construct(sl.ptr(), std::move(v));
+            unsigned char expected = __EMPTY;
+            if (sl.state.compare_exchange_strong(expected, __READY, std::memory_order_acq_rel)) {
+                __hazard_domain::clear(__HP_SEGMENT);
+                return;
+            }
+            /* 消费者等不及把槽作废了, 元素拿回来重新领槽 */
+            v = std::move(*sl.ptr());
+            destroy(sl.ptr());
+        }
+    }
+
+    template <typename... Args>
+    void emplace(Args&&... args)
+    {
+        push(value_type(std::forward<Args>(args)...));
+    }
+
+    /* 队列空时返回 false, 否则把队头元素移到 v 中 */
+    bool try_pop(value_type& v)
+    {
+        for (;;) {
+            segment* s = __hazard_domain::protect(__HP_SEGMENT, head_);
+            if (s->deq_idx.load(std::memory_order_acquire) >= s->enq_idx.load(std::memory_order_acquire) &&
+                s->next.load(std::memory_order_acquire) == nullptr) {
+                __hazard_domain::clear(__HP_SEGMENT);
+                return false;
+            }
+
+            size_t idx = s->deq_idx.fetch_add(1, std::memory_order_acq_rel);
+            if (idx >= __SEGMENT_SIZE) {
+                /* 这一段取完了, 进入下一段 */
+                if (!advance_head(s)) {
+                    __hazard_domain::clear(__HP_SEGMENT);
+                    return false;
+                }
+                continue;
+            }
+
+            slot& sl = s->slots[idx];
+            if (wait_ready(sl)) {
+                v = std::move(*sl.ptr());
+                destroy(sl.ptr());
+                __hazard_domain::clear(__HP_SEGMENT);
+                return true;
+            }
+            /* 槽已经作废, 生产者会重新领槽, 继续取下一个 */
+        }
+    }
+
+    /* 其他线程同时在读写时只是一个近似值 */
+    bool empty() const
+    {
+        segment* s = __hazard_domain::protect(__HP_SEGMENT, head_);
+        bool result = s->deq_idx.load() >= std::min<size_t>(s->enq_idx.load(), __SEGMENT_SIZE) &&
+                      s->next.load() == nullptr;
+        __hazard_domain::clear(__HP_SEGMENT);
+        return result;
+    }
+
+private:
+    concurrent_queue(const concurrent_queue&);
+    concurrent_queue& operator=(const concurrent_queue&);
+
+    static segment* new_segment()
+    {
+        segment* s = segment_allocator::allocate();
+        return new (s) segment;
+    }
+
+    static void delete_segment(segment* s)
+    {
+        s->~segment();
+        segment_allocator::deallocate(s);
+    }
+
+    /* 危险指针的回收函数 */
+    static void reclaim_segment(void* p)
+    {
+        delete_segment(static_cast<segment*>(p));
+    }
+
+    /* s 已满: 没有下一段时挂上新段, 然后把 tail_ 推进到下一段 */
+    void append_segment(segment* s)
+    {
+        segment* next = s->next.load(std::memory_order_acquire);
+        if (!next) {
+            segment* fresh = new_segment();
+            if (s->next.compare_exchange_strong(next, fresh, std::memory_order_acq_rel)) {
+                next = fresh;
+            } else {
+                delete_segment(fresh);      /* 别人先挂上了, 新段还没有公开, 直接释放 */
+            }
+        }
+        tail_.compare_exchange_strong(s, next, std::memory_order_acq_rel);
+    }
+
+    /**
+     *     s 已经取完: 没有下一段时返回 false, 否则把 head_ 推进到下一段. 推进成功的
+     * 线程负责回收 s; 在此之前先保证 tail_ 不再指向 s, 生产者不会再拿到它
+     */
+    bool advance_head(segment* s)
+    {
+        segment* next = s->next.load(std::memory_order_acquire);
+        if (!next) {
+            return false;
+        }
+        segment* expected = s;
+        tail_.compare_exchange_strong(expected, next, std::memory_order_acq_rel);
+        expected = s;
+        if (head_.compare_exchange_strong(expected, next, std::memory_order_acq_rel)) {
+            __hazard_domain::clear(__HP_SEGMENT);
+            __hazard_domain::retire(s, &reclaim_segment);
+        }
+        return true;
+    }
+
+    /* 等槽写好, 等太久就作废它; 返回 true 表示可以取数据 */
+    static bool wait_ready(slot& sl)
+    {
+        for (size_t i = 0; i < __SPIN; ++i) {
+            if (sl.state.load(std::memory_order_acquire) == __READY) {
+                return true;
+            }
+            if (i >= __SPIN / 2) {
+                std::this_thread::yield();
+            }
+        }
+        unsigned char expected = __EMPTY;
+        return !sl.state.compare_exchange_strong(expected, __ABANDONED, std::memory_order_acq_rel);
+    }
+
+private:
+    std::atomic<segment*> head_;        /* 消费者 */
+    char pad_[__WKANGK_STL_CACHE_LINE - sizeof(std::atomic<segment*>)];
+    std::atomic<segment*> tail_;        /* 生产者 */
+};
+
+__WKANGK_STL_END_NAMESPACE
+
+#endif	/* !__WKANGK_STL_CONCURRENT_QUEUE_H__ */
@@ -18,4 +18,32 @@ Copyright © wkangk <wangkangchn@163.com>
 /* 显示具体化 */
 #define __STL_TEMPLATE_NULL template<>
 
+/* 定义 __WKANGK_STL_THREADS 后, 容器默认的 alloc 换为线程安全的 multi_client_alloc,
+未定义时 alloc 与 single_client_alloc 相同, 只能在单线程中使用 */
+// #define __WKANGK_STL_THREADS
+
+/* 定义 __WKANGK_STL_ALLOC_STATS 后, 第二级配置器会统计每种内存块的命中/未命中/归还次数,
+以及 refill/chunk_alloc 的调用次数, 通过 get_stats() 获取. 未定义时计数代码不参与编译 */
+// #define __WKANGK_STL_ALLOC_STATS
+
+/* 定义 __WKANGK_STL_NO_SIMD 后, simd.h 中的填充/比较/查找等内核都使用标量版本 */
+// #define __WKANGK_STL_NO_SIMD
+
+/* 定义 __WKANGK_STL_DEBUG 后, 容器检查下标越界、空容器的 front/back/pop 以及迭代器是否属于
+容器, 出错时打印位置并 abort(), 见 debug.h. 未定义时检查代码不参与编译 */
+// #define __WKANGK_STL_DEBUG
+
+/* 定义 __WKANGK_STL_PARALLEL 后, 大区间上非 POD 元素的构造/拷贝/析构分块交给线程池并行执行,
+见 parallel.h. 元素的构造会在其他线程中进行, 所以同时打开 __WKANGK_STL_THREADS */
+// #define __WKANGK_STL_PARALLEL
+
+#if defined(__WKANGK_STL_PARALLEL) && !defined(__WKANGK_STL_THREADS)
+#define __WKANGK_STL_THREADS
+#endif
+
+/* 缓存行大小, 多线程共享的计数器之间按它填充, 避免伪共享 */
+#ifndef __WKANGK_STL_CACHE_LINE
+#define __WKANGK_STL_CACHE_LINE 64
+#endif
+
 #endif	/* !__WKANGK_STL_CONFIG_H__ */
\ No newline at end of file
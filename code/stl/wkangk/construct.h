@@ -13,10 +13,14 @@ Copyright © wkangk <wangkangchn@163.com>
 #ifndef __WAKNGK_STL_CONSTRUCT_HPP__ 
 #define __WAKNGK_STL_CONSTRUCT_HPP__ 
 #include <new>
+#include <utility>
 
 #include "config.h"
 #include "type_traits.h"
 #include "iterator.h"
+#ifdef __WKANGK_STL_PARALLEL
+#include "parallel.h"
+#endif
 
 
 __WKANGK_STL_BEGIN_NAMESPACE
@@ -26,12 +30,13 @@ __WKANGK_STL_BEGIN_NAMESPACE
 应该是新版的中这几个是全局的, 但是老版中仍是在 std 命名空间中的
 
 c++20 编译的时候就冲突, 但是 11 就不会, 应该就是哪里给放开命名空间了 */
-/* 这个地方只右一个参数吗? 不应该使用可变参数模板??? */
-template <typename Class, typename T>
-inline void construct(Class* cla, const T& value)
+/* 使用可变参数模板, 参数原样转发给构造函数: 传入右值时调用移动构造, 
+emplace 时直接用参数原地构造 */
+template <typename Class, typename... Args>
+inline void construct(Class* cla, Args&&... args)
 {   
-    // 这里是调用 Class::Class(value)
-    new (cla) Class(value);   /* 定位new */
+    // 这里是调用 Class::Class(args...)
+    new (cla) Class(std::forward<Args>(args)...);   /* 定位new */
 }
 
 /* 最泛化的析构, 调用对象的析构 */
@@ -58,6 +63,29 @@ inline void __destory_aux(ForwardIterator first, ForwardIterator last, __false_t
     }
 }
 
+#ifdef __WKANGK_STL_PARALLEL
+/* 连续区间, 元素足够多时分块并行析构. 析构函数不应该抛出异常, 不需要回滚 */
+template <typename T>
+inline void __destory_aux(T* first, T* last, __false_type)
+{
+    const size_t n = last - first;
+    const size_t chunks = __parallel_chunks(n);
+    if (chunks < 2) {
+        for (; first != last; ++first) {
+            destroy(first);
+        }
+        return;
+    }
+    __parallel_chunked(n, chunks,
+        [&](size_t b, size_t e) {
+            for (T* p = first + b; p != first + e; ++p) {
+                destroy(p);
+            }
+        },
+        [](size_t, size_t) {});
+}
+#endif
+
 template <typename ForwardIterator, typename T>
 inline void __destory(ForwardIterator first, ForwardIterator last, T*)
 {   
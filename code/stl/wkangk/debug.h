@@ -0,0 +1,54 @@
+/***************************************************************
+ * @copyright  Copyright © 2026 wkangk.
+ * @file       debug.h
+ * @author     wkangk <wangkangchn@163.com>
+ * @version    v1.0
+ * @brief      调试模式下的越界/空容器/迭代器归属检查
+ * @date       2026-10-16 18:40
+ **************************************************************/
+#ifndef __WKANGK_STL_DEBUG_H__
+#define __WKANGK_STL_DEBUG_H__
+#include <stdlib.h>
+#include <iostream>
+
+#include "config.h"
+
+/* -------------------------------------------------------------------------------
+ *     定义 __WKANGK_STL_DEBUG 后, 容器在下标访问、front/back、pop、insert/erase 以及
+ * 迭代器解引用时检查参数, 不满足时打印出错位置并 abort():
+ *      - 下标必须小于 size()
+ *      - 空容器不能 front/back/pop
+ *      - 传给 vector/small_vector 的 insert/erase 的迭代器必须落在当前的 [begin, end]
+ *        之内, 即属于这个容器
+ *      - hash_table 的 end() 不能解引用, deque 的迭代器不能越出所在的段
+ *
+ *     只检查迭代器的归属和范围, 不检查迭代器是否已经失效: vector 的迭代器就是指针,
+ * 原地扩容、没有扩容的 insert/erase、释放后又分配到同一地址时, 失效的迭代器仍然落在
+ * [begin, end] 之内; deque/list/hash_table 的迭代器也不记录容器的修改.
+ *
+ *     未定义时 __STL_DEBUG_CHECK 展开为空, 条件表达式不会被求值, 发布版本没有任何开销.
+ * ------------------------------------------------------------------------------- */
+#ifdef __WKANGK_STL_DEBUG
+
+__WKANGK_STL_BEGIN_NAMESPACE
+
+__attribute__((noreturn, noinline))
+inline void __stl_debug_fail(const char* file, int line, const char* expr, const char* msg)
+{
+    std::cerr << file << ":" << line << ": wkangk_stl debug check failed: " << msg
+              << " (" << expr << ")" << std::endl;
+    abort();
+}
+
+__WKANGK_STL_END_NAMESPACE
+
+#define __STL_DEBUG_CHECK(cond, msg) \
+    (__builtin_expect(!!(cond), 1) ? (void)0 : wkangk_stl::__stl_debug_fail(__FILE__, __LINE__, #cond, msg))
+
+#else
+
+#define __STL_DEBUG_CHECK(cond, msg) ((void)0)
+
+#endif  /* __WKANGK_STL_DEBUG */
+
+#endif	/* !__WKANGK_STL_DEBUG_H__ */
@@ -9,28 +9,68 @@ Copyright © wkangk <wangkangchn@163.com>
 #ifndef __WKANGK_STL_DEQUE_H__ 
 #define __WKANGK_STL_DEQUE_H__ 
 #include <stdint.h>
+#include <algorithm>
+#include <numeric>
 
 #include "config.h"
 #include "alloc.h"
+#include "construct.h"
+#include "uninitialized.h"
+#include "debug.h"
 
 
 __WKANGK_STL_BEGIN_NAMESPACE
 
 
 
+/* 不超过 n 的最大的 2 的幂, n >= 1 */
+constexpr size_t __deque_floor_pow2(size_t n, size_t p = 1)
+{
+    return p * 2 > n ? p : __deque_floor_pow2(n, p * 2);
+}
+
 /**
- *     计算缓冲区大小
+ *     段大小的策略: 一段大约 Bytes 字节, 但至少 MinElems 个元素. 元素个数取 2 的幂,
+ * 并且在编译期就确定, 迭代器随机访问时的除法/取模由编译器换成移位/掩码.
  *
- * @param [in]  n       期望缓冲区字节数
- * @param [in]  sz      一个元素的字节数
- * @return     总的缓冲区字节数(也就是一段内存的大小)
+ * @param Bytes     一段的目标字节数
+ * @param MinElems  一段至少的元素个数(2 的幂), 避免大元素一段只放一个
  */
-size_t __deque_buf_size(size_t n, size_t sz) 
+template <size_t Bytes, size_t MinElems>
+struct __deque_buf_policy
 {
-    /* 不为 0 就使用用户设置的值
-    为 0, 当元素小于 512, 就分配 512 / sz, 不是很理解为啥要这么搞 */
-    return n != 0 ? n : ( sz < 512 ? size_t(512 / sz) : size_t(1) );
-}
+    static constexpr size_t elems(size_t sz)
+    {
+        return __deque_floor_pow2(Bytes / sz > MinElems ? Bytes / sz : MinElems);
+    }
+};
+
+/* 默认: 一段 512 字节, 放得进 L1, 小 deque 也不浪费 */
+typedef __deque_buf_policy<512, 8> __deque_cache_buf;
+/* 一段一页, 适合元素很多、主要做整段扫描的 deque */
+typedef __deque_buf_policy<4096, 64> __deque_page_buf;
+
+/**
+ *     元素类型对应的段大小策略, 可以按类型特化:
+ *
+ *     template <> struct __deque_buf_traits<message> : public __deque_page_buf {};
+ */
+template <typename T>
+struct __deque_buf_traits : public __deque_cache_buf
+{
+};
+
+/**
+ *     一段的元素个数. BufSiz 不为 0 时使用用户指定的值, 否则由 __deque_buf_traits<T> 决定
+ */
+template <typename T, size_t BufSiz>
+struct __deque_buf_size
+{
+    static constexpr size_t value = BufSiz != 0 ? BufSiz : __deque_buf_traits<T>::elems(sizeof(T));
+};
+
+template <typename T, size_t BufSiz>
+constexpr size_t __deque_buf_size<T, BufSiz>::value;
 
 template <typename T, typename Ref, typename Ptr, size_t BufSiz>
 class __deque_iterator
@@ -38,7 +78,7 @@ class __deque_iterator
 public:
     typedef __deque_iterator<T, T&, T*, BufSiz>     iterator;
     typedef __deque_iterator<T, const T&, const T*, BufSiz>     const_iterator;
-    static size_t buffer_size() { return __deque_buf_size(BufSiz, sizeof(T)); }
+    static constexpr size_t buffer_size() { return __deque_buf_size<T, BufSiz>::value; }
 
     /* 实现迭代器的五个类型 */
     typedef random_access_iterator_tag      iterator_category;
@@ -52,9 +92,38 @@ public:
     typedef __deque_iterator                self;
 
 
+private:
+    /* 段大小是 2 的幂时, 向下取整的除法就是算术右移 */
+    enum { __buf_size = __deque_buf_size<T, BufSiz>::value };
+    typedef typename __bool_type<(__buf_size & (__buf_size - 1)) == 0>::type is_pow2;
+
+    static constexpr int buffer_shift(size_t n = buffer_size(), int s = 0)
+    {
+        return n <= 1 ? s : buffer_shift(n >> 1, s + 1);
+    }
+
+    /* offset 所在的段相对当前段的偏移, 向下取整 */
+    static difference_type node_offset_of(difference_type offset, __true_type)
+    {
+        return offset >> buffer_shift();
+    }
+
+    static difference_type node_offset_of(difference_type offset, __false_type)
+    {
+        /* 
+            负数时先加一再除, 最后再减一, 得到向下取整的结果:
+            offset == -1   -> -1
+            offset == -512 -> -1
+            offset == -513 -> -2
+         */
+        return offset > 0 ? offset / difference_type(buffer_size()) 
+                : -difference_type((-offset - 1) / buffer_size()) - 1;
+    }
+
 public:
     reference operator*() const
     {
+        __STL_DEBUG_CHECK(cur_ && first_ <= cur_ && cur_ < last_, "deque::iterator: not dereferenceable");
         return *cur_;
     }
 
@@ -122,24 +191,9 @@ public:
             cur_ += n;  /* 还在一个缓冲区 */
         } else {
             /* 不再一个缓冲区了, 就要调整所有指针了 */
-            /* 计算 node 偏移 */
-            difference_type node_offset = offset > 0 ? offset / difference_type(buffer_size()) 
-                    : -difference_type((-offset - 1) / buffer_size()) - 1;
-            /* 
-                两个 -1 不是很明白
-                如果 offset == -513
-                    -offset - 1 == 512
-                    -1 - 1 = -2
-
-                    直接除 512
-                    -512 -1
-                    -513 -1 实际应该是 -2
-                    -514 -1 实际应该是 -2
-                    应该就是为了解决这种问题.
-                    在边界的时候先让你小一点, 计算完了再恢复
-             */
+            difference_type node_offset = node_offset_of(offset, is_pow2());
             set_node(node_ + node_offset);
-            cur_ = first_ + (offset - node_offset * difference_type(buffer_size));
+            cur_ = first_ + (offset - node_offset * difference_type(buffer_size()));
         }
 
         return *this;
@@ -162,6 +216,18 @@ public:
         return tmp -= n;
     }
 
+    self operator+(difference_type n) const
+    {
+        self tmp = *this;
+        return tmp += n;
+    }
+
+    self operator-(difference_type n) const
+    {
+        self tmp = *this;
+        return tmp -= n;
+    }
+
     reference operator[](difference_type n) const
     {
         return *(*this += n);   /* 这里要直接返回元素值, 所以最外面还有一个 *  */
@@ -205,10 +271,10 @@ public:
  *     
  * @param T         存储类型
  * @param Alloc     内存分配器
- * @param BufSize   每一段内存的大小, 单位字节数
+ * @param BufSize   每一段的元素个数, 0 表示由 __deque_buf_traits<T> 决定
  */
 template <typename T, typename Alloc=alloc, size_t BufSize=0>
-class deque
+class deque : private __allocator<T, Alloc>
 {
 public:
     typedef T               value_type;
@@ -218,15 +284,16 @@ public:
     typedef pointer*        map_pointer;
     typedef size_t          size_type;
     typedef ptrdiff_t       difference_type;
+    typedef Alloc           allocator_type;
 
     typedef __deque_iterator<T, T&, T*, BufSize> iterator;
 
-    typedef simple_alloc<value_type, Alloc> data_allocator;     /* 元素分配器 */
-    typedef simple_alloc<pointer, Alloc> map_allocator;     /* 分配 map 空间 */
+    typedef __allocator<value_type, Alloc> data_allocator;     /* 元素分配器, 实例放在基类中 */
+    typedef __allocator<pointer, Alloc> map_allocator;     /* 分配 map 空间, 用到时由 get_allocator() 临时构造 */
 
 public:
     deque() : 
-        start_(), finish_(), map_(nullptr), map_size_(0)
+        start_(), finish_(), map_(nullptr), map_size_(0), num_spare_(0)
     {
         create_map_and_nodes(0);
     }
@@ -234,12 +301,47 @@ public:
     /**
      * @param [in]  n 初始元素个数
      */
-    deque(int n, const value_type& value) :
-        start_(), finish_(), map_(0), map_size_(0)
+    explicit deque(const allocator_type& a) : 
+        data_allocator(a), start_(), finish_(), map_(nullptr), map_size_(0), num_spare_(0)
+    {
+        create_map_and_nodes(0);
+    }
+
+    deque(int n, const value_type& value, const allocator_type& a = allocator_type()) :
+        data_allocator(a), start_(), finish_(), map_(0), map_size_(0), num_spare_(0)
     {
         fill_initialize(n, value);
     }
 
+    /* 拷贝时连同配置器一起拷贝, 一次分配好所有段, 再按段整块拷贝 */
+    deque(const deque& x) :
+        data_allocator(x.get_allocator()), start_(), finish_(), map_(nullptr), map_size_(0), num_spare_(0)
+    {
+        create_map_and_nodes(x.size());
+        iterator cur = start_;
+        try {
+            for (iterator it = x.start_; it != x.finish_; ) {
+                difference_type n = std::min(x.segment_end(it) - it.cur_, segment_end(cur) - cur.cur_);
+                wkangk_stl::uninitialized_copy(it.cur_, it.cur_ + n, cur.cur_);
+                advance_in_segment(it, n);
+                advance_in_segment(cur, n);
+            }
+        } catch (...) {
+            destroy(start_, cur);
+            destroy_map_and_nodes();
+            throw;
+        }
+    }
+
+    deque& operator=(const deque& x)
+    {
+        if (this != &x) {
+            deque tmp(x);
+            swap(tmp);
+        }
+        return *this;
+    }
+
     ~deque() 
     {
         destroy(start_, finish_);
@@ -259,16 +361,19 @@ public:
 
     reference operator[](size_type n)
     {
+        __STL_DEBUG_CHECK(n < size(), "deque::operator[]: index out of range");
         return start_[difference_type(n)];
     }
 
     reference front()
     {
+        __STL_DEBUG_CHECK(!empty(), "deque::front: empty deque");
         return *start_;
     }
 
     reference back()
     {
+        __STL_DEBUG_CHECK(!empty(), "deque::back: empty deque");
         // return *(finish_ - 1);  /* 看侯捷老师说的, 我也觉得可以直接这么搞, iterator 定义了 - 运算符, 应该可以吧, 试试 */
 
         /* 不对不对 不能上面这么写, 上面只定义了 两个 iterator 之间的 -, 而没有定义 iterator 与 整数之间的减,
@@ -279,7 +384,7 @@ public:
         return *tmp;
     }
 
-    size_type size()
+    size_type size() const
     {
         return finish_ - start_;    /* 两个 ;; 就是写错了吧 /捂脸 */
     }
@@ -294,6 +399,48 @@ public:
         return finish_ == start_;
     }
 
+    void swap(deque& x)
+    {
+        std::swap(start_, x.start_);
+        std::swap(finish_, x.finish_);
+        std::swap(map_, x.map_);
+        std::swap(map_size_, x.map_size_);
+        std::swap(num_spare_, x.num_spare_);
+        for (size_type i = 0; i < __MAX_SPARE_NODES; ++i) {
+            std::swap(spare_nodes_[i], x.spare_nodes_[i]);
+        }
+        std::swap(static_cast<data_allocator&>(*this), static_cast<data_allocator&>(x));
+    }
+
+    allocator_type get_allocator() const
+    {
+        return data_allocator::get_allocator();
+    }
+
+    /* 元素是整数/浮点数时, 每次按向量比较两边都连续的一段 */
+    friend bool operator==(const deque& x, const deque& y)
+    {
+        if (x.size() != y.size()) {
+            return false;
+        }
+        iterator i = x.start_;
+        iterator j = y.start_;
+        while (i != x.finish_) {
+            difference_type n = std::min(x.segment_end(i) - i.cur_, y.segment_end(j) - j.cur_);
+            if (!wkangk_stl::__simd_equal<T>(i.cur_, i.cur_ + n, j.cur_)) {
+                return false;
+            }
+            advance_in_segment(i, n);
+            advance_in_segment(j, n);
+        }
+        return true;
+    }
+
+    friend bool operator!=(const deque& x, const deque& y)
+    {
+        return !(x == y);
+    }
+
     /* 尾插 */
     void push_back(const value_type& v)
     {
@@ -302,13 +449,25 @@ public:
             ++finish_.cur_;
         } else {
             /* 没有空间了就要重新分配 */
-            push_back_auc(v);
+            push_back_aux(v);
+        }
+    }
+
+    /* 头插 */
+    void push_front(const value_type& v)
+    {
+        if (start_.cur_ != start_.first_) {
+            construct(start_.cur_ - 1, v);
+            --start_.cur_;
+        } else {
+            push_front_aux(v);
         }
     }
 
     /* 尾删 */
     void pop_back()
     {
+        __STL_DEBUG_CHECK(!empty(), "deque::pop_back: empty deque");
         if (finish_.cur_ != finish_.first_) {
             /* 当前段内还有一些元素, 直接删除即可 */
             --finish_.cur_;
@@ -322,6 +481,7 @@ public:
     /* 头删 */
     void pop_front()
     {
+        __STL_DEBUG_CHECK(!empty(), "deque::pop_front: empty deque");
         if (start_.cur_ != start_.last_ - 1) {
             destroy(start_.cur_);
             ++start_.cur_;
@@ -331,9 +491,9 @@ public:
     }
 
 private:
-    static size_type buffer_size() 
+    static constexpr size_type buffer_size() 
     {
-        return __deque_buf_size(BufSize, sizeof(value_type));
+        return __deque_buf_size<T, BufSize>::value;
     }
 
     /**
@@ -369,7 +529,7 @@ private:
         /* map 有一个最小值, 最小管理 8 个内存段 */
         map_size_ = std::max(initial_map_size(), num_nodes + 2);
 
-        map_ = map_allocator::allocate(map_size_);
+        map_ = map_alloc().allocate(map_size_);
 
         /* 初始使头尾指向最中间, 以使两边的扩增均匀 */
         map_pointer nstart = map_ + (map_size_ - num_nodes) / 2;
@@ -390,24 +550,78 @@ private:
     }
 
     /* 分配空间, 设置值, 调整指针 */
-    void push_back_auc(const value_type& v)
+    void push_back_aux(const value_type& v)
     {
         value_type v_copy = v;
-        reserver_map_at_back();
-        *(finish_.node_ + 1) = allocate_node();
-
-        construct(finish_.cur_, v_copy);
+        reserve_map_at_back();
+        *(finish_.node_ + 1) = take_node();
+
+        try {
+            construct(finish_.cur_, v_copy);
+        } catch (...) {
+            recycle_node(*(finish_.node_ + 1));
+            throw;
+        }
         finish_.set_node(finish_.node_ + 1);
         finish_.cur_ = finish_.first_;
     }
 
+    /* start_ 在段首, 在前面接上一段, 新元素放在它的最后一个位置 */
+    void push_front_aux(const value_type& v)
+    {
+        value_type v_copy = v;
+        reserve_map_at_front();
+        *(start_.node_ - 1) = take_node();
+
+        try {
+            construct(*(start_.node_ - 1) + buffer_size() - 1, v_copy);
+        } catch (...) {
+            recycle_node(*(start_.node_ - 1));
+            throw;
+        }
+        start_.set_node(start_.node_ - 1);
+        start_.cur_ = start_.last_ - 1;
+    }
+
+    /* it 所在段中最后一个元素的下一个位置 */
+    pointer segment_end(const iterator& it) const
+    {
+        return it.node_ == finish_.node_ ? finish_.cur_ : it.last_;
+    }
+
+    /* 在段内前进 n(>0) 步, 走到段尾时进入下一段 */
+    static void advance_in_segment(iterator& it, difference_type n)
+    {
+        it.cur_ += n - 1;
+        ++it;
+    }
+
     static size_type initial_map_size() { return 8; }
+    map_allocator map_alloc() const { return map_allocator(get_allocator()); }
     pointer allocate_node() { return data_allocator::allocate(buffer_size()); }
 
+    /**
+     *     段的缓存: 两端空出来的段先留着(最多 __MAX_SPARE_NODES 个), 需要新段时优先使用.
+     * 队列这种一端进一端出的用法, 稳定之后不再分配和释放段.
+     */
+    pointer take_node()
+    {
+        return num_spare_ ? spare_nodes_[--num_spare_] : allocate_node();
+    }
+
+    void recycle_node(pointer n)
+    {
+        if (num_spare_ < __MAX_SPARE_NODES) {
+            spare_nodes_[num_spare_++] = n;
+        } else {
+            deallocate_node(n);
+        }
+    }
+
     /**
      *  在 map 的后面添加新的结点     
      */
-    void reserver_map_at_back(size_type nodes_to_add=1)
+    void reserve_map_at_back(size_type nodes_to_add=1)
     {
         /* map 尾部没有空间了, finish_ 是最后一个使用的节点, 因为
         这里是后面添加, 所以只考虑尾部 map 的余量 */
@@ -416,6 +630,14 @@ private:
         }
     }
 
+    /* 在 map 的前面添加新的结点, start_ 前面至少要空出 nodes_to_add 个位置 */
+    void reserve_map_at_front(size_type nodes_to_add=1)
+    {
+        if (nodes_to_add > size_type(start_.node_ - map_)) {
+            reallocate_map(nodes_to_add, true);
+        }
+    }
+
     /**
      * 因为 deque 是前后都可以操作, 所以这里有第二个参数, 用来表示
      * 添加的新空间是在之前添加还是在之后添加
@@ -443,14 +665,14 @@ private:
         } else {
             /* 空间不够了, 就重新分配. 同样每次增加时, 还是有一个最小大小限制 */
             size_type new_map_size = map_size_ + std::max(map_size_, nodes_to_add) + 2;
-            map_pointer new_map = map_allocator::allocate(new_map_size);
+            map_pointer new_map = map_alloc().allocate(new_map_size);
             /* 同样新位置在新 map 中间, 使用 add_at_front 表明向前扩展一个 */
             new_nstart = new_map + (new_map_size - new_num_nodes) / 2 + (add_at_front ? nodes_to_add : 0);
 
             /* 原 map 内容拷贝新 map 中 */
             std::copy(start_.node_, finish_.node_ + 1, new_nstart);
-            map_allocator::deallocate(map_, map_size_); /* 要记得删除之前的元素 */
-            map_ = new_nstart;
+            map_alloc().deallocate(map_, map_size_); /* 要记得删除之前的元素 */
+            map_ = new_map;
             map_size_ = new_map_size;
         }
 
@@ -463,7 +685,10 @@ private:
         for (map_pointer cur = start_.node_; cur <= finish_.node_; ++cur) {
             deallocate_node(*cur);
         }
-        map_allocator::deallocate(map_, map_size_);
+        while (num_spare_) {
+            deallocate_node(spare_nodes_[--num_spare_]);
+        }
+        map_alloc().deallocate(map_, map_size_);
     }
 
     void deallocate_node(pointer n) 
@@ -473,8 +698,8 @@ private:
 
     void pop_back_aux()
     {   
-        /* 没必要删掉吧, 直接调整指针不行吗? */
-        deallocate_node(finish_.first_);
+        /* 空出来的段放进缓存, 下次 push 时直接使用 */
+        recycle_node(finish_.first_);
         finish_.set_node(finish_.node_ - 1);
         finish_.cur_ = finish_.last_ - 1;
         destroy(finish_.cur_);      /* 左闭右开 */
@@ -483,7 +708,7 @@ private:
     void pop_front_aux()
     {
         destroy(start_.cur_);
-        deallocate_node(start_.first_);
+        recycle_node(start_.first_);
         start_.set_node(start_.node_ + 1);
         start_.cur_ = start_.first_;
     }
@@ -494,8 +719,174 @@ private:
 
     map_pointer map_;       /* 类似与页表存储一段一段的内存 */
     size_type map_size_;    /* map 的大小 */
+
+    enum { __MAX_SPARE_NODES = 2 };
+    pointer spare_nodes_[__MAX_SPARE_NODES];    /* 空闲段的缓存 */
+    size_type num_spare_;
 };
 
 
+
+/* -------------------------------------------------------------------------------
+ *     按段处理的算法: deque 的元素在每一段内是连续的, 把区间拆成若干段交给指针版本,
+ * 省去迭代器每次 ++ 时的跨段判断, POD 类型还能走 memmove/向量化的路径.
+ * ------------------------------------------------------------------------------- */
+/* 对 [first, last) 中的每一段连续内存调用 fn(begin, end) */
+template <typename T, typename Ref, typename Ptr, size_t BufSiz, typename Fn>
+void __deque_for_each_segment(__deque_iterator<T, Ref, Ptr, BufSiz> first, 
+                              __deque_iterator<T, Ref, Ptr, BufSiz> last, Fn& fn)
+{
+    typedef __deque_iterator<T, Ref, Ptr, BufSiz> iterator;
+    if (first.cur_ == last.cur_) {
+        return;
+    }
+    if (first.node_ == last.node_) {
+        fn(Ptr(first.cur_), Ptr(last.cur_));
+        return;
+    }
+    fn(Ptr(first.cur_), Ptr(first.last_));
+    for (typename iterator::map_pointer node = first.node_ + 1; node != last.node_; ++node) {
+        fn(Ptr(*node), Ptr(*node + iterator::buffer_size()));
+    }
+    fn(Ptr(last.first_), Ptr(last.cur_));
+}
+
+
+/* 连续区间拷贝到 deque, 每次拷贝到目标段的末尾 */
+template <typename U, typename T, typename Ref, typename Ptr, size_t BufSiz>
+__deque_iterator<T, Ref, Ptr, BufSiz> copy(U* first, U* last, __deque_iterator<T, Ref, Ptr, BufSiz> result)
+{
+    while (first != last) {
+        ptrdiff_t n = std::min(last - first, result.last_ - result.cur_);
+        std::copy(first, first + n, result.cur_);
+        first += n;
+        result += n;
+    }
+    return result;
+}
+
+template <typename T, typename OutputIterator>
+OutputIterator __deque_copy_segment(const T* first, const T* last, OutputIterator result)
+{
+    return std::copy(first, last, result);
+}
+
+template <typename T, typename T2, typename Ref, typename Ptr, size_t BufSiz>
+__deque_iterator<T2, Ref, Ptr, BufSiz> __deque_copy_segment(const T* first, const T* last, 
+                                                            __deque_iterator<T2, Ref, Ptr, BufSiz> result)
+{
+    return wkangk_stl::copy(first, last, result);
+}
+
+/* 从 deque 拷贝出去, 目标也可以是 deque */
+template <typename T, typename Ref, typename Ptr, size_t BufSiz, typename OutputIterator>
+OutputIterator copy(__deque_iterator<T, Ref, Ptr, BufSiz> first, 
+                    __deque_iterator<T, Ref, Ptr, BufSiz> last, OutputIterator result)
+{
+    auto fn = [&result](const T* b, const T* e) { result = __deque_copy_segment(b, e, result); };
+    __deque_for_each_segment(first, last, fn);
+    return result;
+}
+
+
+template <typename T, typename Ref, typename Ptr, size_t BufSiz, typename U>
+void fill(__deque_iterator<T, Ref, Ptr, BufSiz> first, __deque_iterator<T, Ref, Ptr, BufSiz> last, const U& value)
+{
+    const T v(value);
+    auto fn = [&v](T* b, T* e) { __simd_fill_n<T>(b, e - b, v); };
+    __deque_for_each_segment(first, last, fn);
+}
+
+
+/* 逐段用 simd.h 中的 find 查找 */
+template <typename T, typename Ref, typename Ptr, size_t BufSiz, typename U>
+__deque_iterator<T, Ref, Ptr, BufSiz> find(__deque_iterator<T, Ref, Ptr, BufSiz> first, 
+                                           __deque_iterator<T, Ref, Ptr, BufSiz> last, const U& value)
+{
+    while (first.node_ != last.node_) {
+        T* pos = wkangk_stl::find(first.cur_, first.last_, value);
+        if (pos != first.last_) {
+            first.cur_ = pos;
+            return first;
+        }
+        first.set_node(first.node_ + 1);
+        first.cur_ = first.first_;
+    }
+    first.cur_ = wkangk_stl::find(first.cur_, last.cur_, value);
+    return first;
+}
+
+
+template <typename T, typename Ref, typename Ptr, size_t BufSiz, typename Function>
+Function for_each(__deque_iterator<T, Ref, Ptr, BufSiz> first, 
+                  __deque_iterator<T, Ref, Ptr, BufSiz> last, Function f)
+{
+    auto fn = [&f](Ptr b, Ptr e) {
+        for (; b != e; ++b) {
+            f(*b);
+        }
+    };
+    __deque_for_each_segment(first, last, fn);
+    return f;
+}
+
+
+template <typename T, typename Ref, typename Ptr, size_t BufSiz, typename U>
+U accumulate(__deque_iterator<T, Ref, Ptr, BufSiz> first, __deque_iterator<T, Ref, Ptr, BufSiz> last, U init)
+{
+    auto fn = [&init](const T* b, const T* e) { init = std::accumulate(b, e, init); };
+    __deque_for_each_segment(first, last, fn);
+    return init;
+}
+
+template <typename T, typename Ref, typename Ptr, size_t BufSiz, typename U, typename BinaryOperation>
+U accumulate(__deque_iterator<T, Ref, Ptr, BufSiz> first, __deque_iterator<T, Ref, Ptr, BufSiz> last, 
+             U init, BinaryOperation op)
+{
+    auto fn = [&init, &op](const T* b, const T* e) { init = std::accumulate(b, e, init, op); };
+    __deque_for_each_segment(first, last, fn);
+    return init;
+}
+
+
+/**
+ *     连续区间拷贝构造到 deque 的未初始化空间, 每段交给指针版本(POD 直接整块拷贝).
+ * 中途出错时把已经构造的析构掉
+ */
+template <typename U, typename T, typename Ref, typename Ptr, size_t BufSiz>
+__deque_iterator<T, Ref, Ptr, BufSiz> uninitialized_copy(U* first, U* last, 
+                                                         __deque_iterator<T, Ref, Ptr, BufSiz> result)
+{
+    __deque_iterator<T, Ref, Ptr, BufSiz> cur = result;
+    try {
+        while (first != last) {
+            ptrdiff_t n = std::min(last - first, cur.last_ - cur.cur_);
+            wkangk_stl::uninitialized_copy(first, first + n, cur.cur_);
+            first += n;
+            cur += n;
+        }
+    } catch (...) {
+        destroy(result, cur);
+        throw;
+    }
+    return cur;
+}
+
+/* deque 中的元素拷贝构造到 result 开始的未初始化空间, result 也可以是 deque */
+template <typename T, typename Ref, typename Ptr, size_t BufSiz, typename ForwardIterator>
+ForwardIterator uninitialized_copy(__deque_iterator<T, Ref, Ptr, BufSiz> first, 
+                                   __deque_iterator<T, Ref, Ptr, BufSiz> last, ForwardIterator result)
+{
+    ForwardIterator cur = result;
+    try {
+        auto fn = [&cur](const T* b, const T* e) { cur = wkangk_stl::uninitialized_copy(b, e, cur); };
+        __deque_for_each_segment(first, last, fn);
+    } catch (...) {
+        destroy(result, cur);
+        throw;
+    }
+    return cur;
+}
+
 __WKANGK_STL_END_NAMESPACE
 #endif	/* !__WKANGK_STL_DEQUE_H__ */
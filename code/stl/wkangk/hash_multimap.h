@@ -30,6 +30,7 @@ public:
     typedef typename ht::value_type value_type;
     typedef typename ht::hasher hasher;
     typedef typename ht::key_equal key_equal;
+    typedef typename ht::allocator_type allocator_type;
     
     typedef typename ht::size_type size_type;
     typedef typename ht::difference_type difference_type;
@@ -50,6 +51,21 @@ public:
     {
     }
 
+    hash_multimap(size_t n, const hasher& hf, const key_equal& eql, const allocator_type& a = allocator_type()) : 
+        rep_(n, hf, eql, a)
+    {
+    }
+
+    allocator_type get_allocator() const
+    {
+        return rep_.get_allocator();
+    }
+
+    void swap(hash_multimap& x)
+    {
+        rep_.swap(x.rep_);
+    }
+
 public:
     /* hash_multimap 和 hash_multimap 都是配接器, 获取其所有方法都可以基于底层数据结构进行操作 */
     size_type size() const { return rep_.size(); }
@@ -12,6 +12,7 @@
 #include <algorithm>
 
 #include "vector.h"
+#include "debug.h"
 
 
 __WKANGK_STL_BEGIN_NAMESPACE
@@ -51,7 +52,11 @@ public:
     __hashtable_iterator() {}
     __hashtable_iterator(node* n, hashtable* tab) : cur_(n), ht_(tab) {}
 
-    reference operator*() const { return cur_->value_; }
+    reference operator*() const
+    {
+        __STL_DEBUG_CHECK(cur_ != nullptr, "hash_table::iterator: cannot dereference end()");
+        return cur_->value_;
+    }
     pointer operator->() const { return &(operator*()); }
     iterator& operator++() 
     {
@@ -120,7 +125,11 @@ struct __hashtable_const_iterator
         : cur_(n), ht_(tab) {}
     __hashtable_const_iterator() {}
     __hashtable_const_iterator(const iterator& it) : cur_(it.cur_), ht_(it.ht_) {}
-    reference operator*() const { return cur_->value_; }
+    reference operator*() const
+    {
+        __STL_DEBUG_CHECK(cur_ != nullptr, "hash_table::iterator: cannot dereference end()");
+        return cur_->value_;
+    }
     pointer operator->() const { return &(operator*()); }
 
     const_iterator& operator++()
@@ -185,10 +194,10 @@ size_t max_buncket_count()
 }
 
 template <typename Key, typename Value, typename HashFcn, typename ExtractKey, typename EqualKey, typename Alloc>
-class hash_table
+class hash_table : private __allocator<__hashtable_node<Value>, Alloc>
 {
     typedef __hashtable_node<Value> node;
-    typedef simple_alloc<node, Alloc> node_allocator;
+    typedef __allocator<node, Alloc> node_allocator;
 
 public:
     typedef Key key_type;
@@ -202,6 +211,7 @@ public:
     typedef const value_type* const_pointer;
     typedef value_type&       reference;
     typedef const value_type& const_reference;
+    typedef Alloc             allocator_type;
 
     typedef __hashtable_iterator<Key, Value, HashFcn, ExtractKey, EqualKey, Alloc>  iterator;
     typedef __hashtable_const_iterator<Key, Value, HashFcn, 
@@ -210,12 +220,29 @@ public:
     friend struct __hashtable_iterator<Key, Value, HashFcn, ExtractKey, EqualKey, Alloc>;
     friend struct __hashtable_const_iterator<Key, Value, HashFcn, ExtractKey, EqualKey, Alloc>;
 
-    hash_table(size_type n, const hasher& hf, const key_equal& eql) :
-        hash_(hf), equals_(eql), get_key_(ExtractKey()), num_elements_(0)        
+    hash_table(size_type n, const hasher& hf, const key_equal& eql, const allocator_type& a = allocator_type()) :
+        node_allocator(a), hash_(hf), equals_(eql), get_key_(ExtractKey()), buckets_(a), num_elements_(0)        
     {
         initialize_buckets(n);
     }
 
+    /* 拷贝时连同配置器一起拷贝 */
+    hash_table(const hash_table& x) :
+        node_allocator(x.get_allocator()), hash_(x.hash_), equals_(x.equals_), get_key_(x.get_key_), 
+        buckets_(x.get_allocator()), num_elements_(0)
+    {
+        copy_from(x);
+    }
+
+    hash_table& operator=(const hash_table& x)
+    {
+        if (this != &x) {
+            hash_table tmp(x);
+            swap(tmp);
+        }
+        return *this;
+    }
+
     ~hash_table() { clear(); }
 
 public:
@@ -274,7 +301,7 @@ public:
         if (num_elements_hit > old_n) {
             const size_type n = next_size(old_n);
             if (n > old_n) {
-                vector<node*, Alloc> tmp(n, nullptr);
+                vector<node*, Alloc> tmp(n, nullptr, get_allocator());
                 /* 一个桶一个桶的重新散列 */
                 for (size_type bucket = 0; bucket < old_n; ++bucket) {
                     node* first = buckets_[bucket];
@@ -295,14 +322,8 @@ public:
 
     void clear()
     {
-        for (size_type i = 0; i < buckets_.size(); ++i) {
-            node* cur = buckets_[i];
-            while (cur != nullptr) {
-                node* next = cur->next_;
-                delete_node(cur);
-                cur = next;
-            }
-            buckets_[i] = nullptr;
+        if (num_elements_ != 0) {
+            clear_aux(typename __alloc_traits<Alloc>::has_bulk_release());
         }
 
         num_elements_ = 0;
@@ -311,6 +332,21 @@ public:
         这也就是为什么 clear 后, 容器容量是不变的!!! */
     }
 
+    void swap(hash_table& x)
+    {
+        std::swap(hash_, x.hash_);
+        std::swap(equals_, x.equals_);
+        std::swap(get_key_, x.get_key_);
+        buckets_.swap(x.buckets_);
+        std::swap(num_elements_, x.num_elements_);
+        std::swap(static_cast<node_allocator&>(*this), static_cast<node_allocator&>(x));
+    }
+
+    allocator_type get_allocator() const
+    {
+        return node_allocator::get_allocator();
+    }
+
     /**
      * @return     删除的元素个数
      */
@@ -423,6 +459,64 @@ private:
         num_elements_ = 0;
     }
 
+    void clear_aux(__false_type)
+    {
+        for (size_type i = 0; i < buckets_.size(); ++i) {
+            node* cur = buckets_[i];
+            while (cur != nullptr) {
+                node* next = cur->next_;
+                delete_node(cur);
+                cur = next;
+            }
+            buckets_[i] = nullptr;
+        }
+    }
+
+    /* 配置器可以一次性回收: 只析构元素, 节点一起回收. 桶数组用的是另一份配置器, 不受影响 */
+    void clear_aux(__true_type)
+    {
+        destroy_values(typename __type_traits<Value>::has_trivial_destructor());
+        std::fill(buckets_.begin(), buckets_.end(), (node*)(0));
+        node_allocator::get_allocator().reset();
+    }
+
+    void destroy_values(__true_type)
+    {
+    }
+
+    void destroy_values(__false_type)
+    {
+        for (size_type i = 0; i < buckets_.size(); ++i) {
+            for (node* cur = buckets_[i]; cur; cur = cur->next_) {
+                wkangk_stl::destroy(&cur->value_);
+            }
+        }
+    }
+
+    /* 桶的个数与 x 相同, 每个桶中的链表按原来的顺序复制 */
+    void copy_from(const hash_table& x)
+    {
+        buckets_.reserve(x.buckets_.size());
+        buckets_.insert(buckets_.end(), x.buckets_.size(), (node*)(0));
+        try {
+            for (size_type i = 0; i < x.buckets_.size(); ++i) {
+                const node* cur = x.buckets_[i];
+                if (cur) {
+                    node* copy = new_node(cur->value_);
+                    buckets_[i] = copy;
+                    for (const node* next = cur->next_; next; next = next->next_) {
+                        copy->next_ = new_node(next->value_);
+                        copy = copy->next_;
+                    }
+                }
+            }
+            num_elements_ = x.num_elements_;
+        } catch (...) {
+            clear();
+            throw;
+        }
+    }
+
     /* 获取下一个可用空间 */
     size_type next_size(size_type n)
     {
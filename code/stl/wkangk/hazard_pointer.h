@@ -0,0 +1,203 @@
+/***************************************************************
+ * @copyright  Copyright © 2026 wkangk.
+ * @file       hazard_pointer.h
+ * @author     wkangk <wangkangchn@163.com>
+ * @version    v1.0
+ * @brief      危险指针: 无锁结构中摘下的节点的安全回收
+ * @date       2026-10-16 23:00
+ **************************************************************/
+#ifndef __WKANGK_STL_HAZARD_POINTER_H__
+#define __WKANGK_STL_HAZARD_POINTER_H__
+#include <stddef.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "config.h"
+
+__WKANGK_STL_BEGIN_NAMESPACE
+
+/* -------------------------------------------------------------------------------
+ *     无锁结构中, 一个线程把节点摘下来以后, 其他线程可能刚刚读到这个节点的地址,
+ * 还没有来得及访问, 所以不能马上释放. 危险指针的做法:
+ *      - 访问共享指针之前, 先把它登记到自己的危险指针中(protect), 登记之后再读一次,
+ *        确认它还没有被摘下
+ *      - 摘下的节点交给 retire(), 先放进本线程的待回收列表, 攒够一批后扫描所有线程
+ *        的危险指针, 没有被任何线程登记的节点才真正回收
+ *
+ *     每个线程第一次使用时领取一条记录, 线程退出时归还, 记录中没有回收完的节点
+ * 留给下一个领取这条记录的线程. 回收函数是普通的函数指针, 所以节点要用无状态的
+ * 配置器分配.
+ * ------------------------------------------------------------------------------- */
+class __hazard_domain
+{
+public:
+    enum { __SLOTS = 2 };       /* 每个线程同时持有的危险指针个数 */
+
+    typedef void (*reclaim_fn)(void*);
+
+    static __hazard_domain& instance()
+    {
+        static __hazard_domain domain;
+        return domain;
+    }
+
+    /* 读出 src 并登记到当前线程的第 i 个危险指针, 返回的指针在 clear(i) 之前不会被回收 */
+    template <typename T>
+    static T* protect(size_t i, const std::atomic<T*>& src)
+    {
+        std::atomic<void*>& hp = local()->hazard[i];
+        T* p = src.load(std::memory_order_acquire);
+        for (;;) {
+            hp.store(p, std::memory_order_seq_cst);
+            T* again = src.load(std::memory_order_seq_cst);
+            if (again == p) {
+                return p;
+            }
+            p = again;
+        }
+    }
+
+    static void clear(size_t i)
+    {
+        local()->hazard[i].store(nullptr, std::memory_order_release);
+    }
+
+    /* p 已经从结构中摘下, 没有线程再登记它时调用 reclaim(p) */
+    static void retire(void* p, reclaim_fn reclaim)
+    {
+        record* r = local();
+        r->retired.push_back(retired_node(p, reclaim));
+        if (r->retired.size() >= instance().scan_threshold()) {
+            instance().scan(r);
+        }
+    }
+
+private:
+    struct retired_node
+    {
+        void* ptr;
+        reclaim_fn reclaim;
+
+        retired_node(void* p, reclaim_fn fn) : ptr(p), reclaim(fn) {}
+    };
+
+    struct record
+    {
+        std::atomic<void*> hazard[__SLOTS];
+        std::atomic<bool> active;
+        record* next;
+        std::vector<retired_node> retired;      /* 只有持有记录的线程访问 */
+        char pad[__WKANGK_STL_CACHE_LINE];      /* 与下一条记录的危险指针分开 */
+
+        record() : active(true), next(nullptr)
+        {
+            for (size_t i = 0; i < __SLOTS; ++i) {
+                hazard[i].store(nullptr);
+            }
+        }
+    };
+
+    /* 线程退出时归还记录 */
+    struct owner
+    {
+        record* r;
+
+        owner() : r(instance().acquire()) {}
+        ~owner() { instance().release(r); }
+    };
+
+    __hazard_domain() : head_(nullptr), count_(0) {}
+
+    /* 进程退出时已经没有其他线程在访问了, 剩下的节点全部回收 */
+    ~__hazard_domain()
+    {
+        record* r = head_.load();
+        while (r) {
+            for (size_t i = 0; i < r->retired.size(); ++i) {
+                r->retired[i].reclaim(r->retired[i].ptr);
+            }
+            record* next = r->next;
+            delete r;
+            r = next;
+        }
+    }
+
+    __hazard_domain(const __hazard_domain&);
+    __hazard_domain& operator=(const __hazard_domain&);
+
+    static record* local()
+    {
+        static thread_local owner o;
+        return o.r;
+    }
+
+    /* 优先复用已经归还的记录, 没有时新建一条挂到链表头 */
+    record* acquire()
+    {
+        for (record* r = head_.load(std::memory_order_acquire); r; r = r->next) {
+            bool expected = false;
+            if (!r->active.load(std::memory_order_relaxed) &&
+                r->active.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return r;
+            }
+        }
+        record* r = new record;
+        record* old = head_.load(std::memory_order_relaxed);
+        do {
+            r->next = old;
+        } while (!head_.compare_exchange_weak(old, r, std::memory_order_release, std::memory_order_relaxed));
+        count_.fetch_add(1, std::memory_order_relaxed);
+        return r;
+    }
+
+    void release(record* r)
+    {
+        for (size_t i = 0; i < __SLOTS; ++i) {
+            r->hazard[i].store(nullptr, std::memory_order_release);
+        }
+        if (!r->retired.empty()) {
+            scan(r);
+        }
+        r->active.store(false, std::memory_order_release);
+    }
+
+    /* 待回收的节点数超过危险指针总数的两倍时扫描, 每次至少能回收一半 */
+    size_t scan_threshold() const
+    {
+        return std::max<size_t>(64, 2 * __SLOTS * count_.load(std::memory_order_relaxed));
+    }
+
+    /* 回收 r 的待回收列表中没有被任何线程登记的节点 */
+    void scan(record* r)
+    {
+        std::vector<void*> hazards;
+        for (record* p = head_.load(std::memory_order_acquire); p; p = p->next) {
+            for (size_t i = 0; i < __SLOTS; ++i) {
+                void* h = p->hazard[i].load(std::memory_order_seq_cst);
+                if (h) {
+                    hazards.push_back(h);
+                }
+            }
+        }
+        std::sort(hazards.begin(), hazards.end());
+
+        std::vector<retired_node> keep;
+        for (size_t i = 0; i < r->retired.size(); ++i) {
+            if (std::binary_search(hazards.begin(), hazards.end(), r->retired[i].ptr)) {
+                keep.push_back(r->retired[i]);
+            } else {
+                r->retired[i].reclaim(r->retired[i].ptr);
+            }
+        }
+        r->retired.swap(keep);
+    }
+
+private:
+    std::atomic<record*> head_;         /* 所有线程的记录, 只增不减 */
+    std::atomic<size_t> count_;
+};
+
+__WKANGK_STL_END_NAMESPACE
+
+#endif	/* !__WKANGK_STL_HAZARD_POINTER_H__ */
@@ -9,6 +9,7 @@ Copyright © wkangk <wangkangchn@163.com>
 #ifndef __WKANGK_STL_ITERATOR_H__ 
 #define __WKANGK_STL_ITERATOR_H__ 
 #include <stddef.h>
+#include <iterator>
 
 #include "config.h"
 
@@ -157,14 +158,24 @@ inline 真正的作用是打破编译器设置的单定义规则. 编译器对
 而在头文件中声明 inline 时, 就是告知编译器消除单定义原则, 可以允许不同的文件
 中有多个实现, 但是要求所有的实现必须相同! 
  */
+/* 标准库容器的迭代器用的是 std:: 中的 tag, 转换为这里的 tag, 
+distance/advance 以及容器的区间操作才能接受 std 容器的迭代器 */
+template <typename Tag>
+inline Tag __iterator_tag(Tag tag) { return tag; }
+inline input_iterator_tag __iterator_tag(std::input_iterator_tag) { return input_iterator_tag(); }
+inline output_iterator_tag __iterator_tag(std::output_iterator_tag) { return output_iterator_tag(); }
+inline forward_iterator_tag __iterator_tag(std::forward_iterator_tag) { return forward_iterator_tag(); }
+inline bidirectional_iterator_tag __iterator_tag(std::bidirectional_iterator_tag) { return bidirectional_iterator_tag(); }
+inline random_access_iterator_tag __iterator_tag(std::random_access_iterator_tag) { return random_access_iterator_tag(); }
+
 template <typename Iterator>
-inline typename iterator_traits<Iterator>::iterator_category
-iterator_category(const Iterator&)
+inline auto iterator_category(const Iterator&)
+    -> decltype(__iterator_tag(typename iterator_traits<Iterator>::iterator_category()))
 {   
     /* 编译器无法区分 iterator_category 到底是类内的成员还是类型, 
     默认会编译器会认为是成员. 所以当使用类型的时候要使用 typename
     显式告诉编译器  */
-    return typename iterator_traits<Iterator>::iterator_category();
+    return __iterator_tag(typename iterator_traits<Iterator>::iterator_category());
 }
 
 /* 为啥要返回指针?? 没理解 */
@@ -14,6 +14,7 @@ Copyright © wkangk <wangkangchn@163.com>
 #include "alloc.h"
 #include "construct.h"
 #include "uninitialized.h"
+#include "debug.h"
 
 
 __WKANGK_STL_BEGIN_NAMESPACE
@@ -34,6 +35,7 @@ struct __list_node
 template <typename T, typename Ref, typename Ptr>
 class __list_iterator
 {
+public:     /* 类型要公开, iterator_traits 才能萃取 */
     /* 最近突然发现了一个问题是, 大部分库都会将类型的定义放在类开头,
     之前还没太在意, 但是最近看《深入探索 C++ 对象模型》的时候, 发现
     这其实是有原因的, 具体原因请参阅《深入探索 C++ 对象模型》 第 91 页 */
@@ -107,12 +109,12 @@ public:
 /* list 具体容器, 容器应该是由具体迭代器产出
 因为只有自己才知道自己怎么遍历 */
 template <typename T, typename Alloc = alloc>
-class list
+class list : private __allocator<__list_node<T>, Alloc>
 {
     typedef __list_node<T>  list_node;
     typedef list_node*      link_type;
     /* 将字节分配器转为字节分配器 */
-    typedef simple_alloc<list_node, Alloc>  list_node_allocator;
+    typedef __allocator<list_node, Alloc>  list_node_allocator;
 
 public:
     typedef __list_iterator<T, T&, T*> iterator;
@@ -120,16 +122,41 @@ public:
     typedef value_type&         reference;
     typedef const value_type&         const_reference;
     typedef size_t  size_type;
+    typedef Alloc   allocator_type;
 
     list()
     {
         empty_initialize();
     }
 
+    explicit list(const allocator_type& a) : list_node_allocator(a)
+    {
+        empty_initialize();
+    }
+
+    /* 拷贝时连同配置器一起拷贝 */
+    list(const list& x) : list_node_allocator(x.get_allocator())
+    {
+        empty_initialize();
+        for (link_type cur = static_cast<link_type>(x.node_->next_); cur != x.node_; 
+             cur = static_cast<link_type>(cur->next_)) {
+            push_back(cur->data_);
+        }
+    }
+
+    list& operator=(const list& x)
+    {
+        if (this != &x) {
+            list tmp(x);
+            swap(tmp);
+        }
+        return *this;
+    }
+
     ~list()
     {
         clear();
-        put_node(node_);
+        put_sentinel(node_);
     }
 
 public:
@@ -159,11 +186,13 @@ public:
 
     reference front()
     {
+        __STL_DEBUG_CHECK(!empty(), "list::front: empty list");
         return *begin();
     }
 
     reference back()
     {
+        __STL_DEBUG_CHECK(!empty(), "list::back: empty list");
         return *(--end());
     }
 
@@ -186,28 +215,24 @@ public:
 
     void clear()
     {
-        link_type cur = static_cast<link_type>(node_->next_);
-        while (cur != node_) {
-            link_type tmp = cur;
-            cur = static_cast<link_type>(cur->next_);
-            destroy_node(tmp);
-        }
-        node_->next_ = node_;
-        node_->prev_ = node_;
+        clear_aux(typename __alloc_traits<Alloc>::has_bulk_release());
     }
 
     void pop_back() 
     { 
+        __STL_DEBUG_CHECK(!empty(), "list::pop_back: empty list");
         iterator tmp = end();
         erase(--tmp);
     }
     void pop_front() 
     { 
+        __STL_DEBUG_CHECK(!empty(), "list::pop_front: empty list");
         erase(begin()); 
     }
 
     iterator erase(iterator position) 
     {
+        __STL_DEBUG_CHECK(position.node_ != node_, "list::erase: cannot erase end()");
         link_type next_node = link_type(position.node_->next_);
         link_type prev_node = link_type(position.node_->prev_);
         prev_node->next_ = next_node;
@@ -216,6 +241,18 @@ public:
         return iterator(next_node);
     }
 
+    /* 只需交换哨兵节点和配置器 */
+    void swap(list& x)
+    {
+        std::swap(node_, x.node_);
+        std::swap(static_cast<list_node_allocator&>(*this), static_cast<list_node_allocator&>(x));
+    }
+
+    allocator_type get_allocator() const
+    {
+        return list_node_allocator::get_allocator();
+    }
+
 
 private:
     /**
@@ -234,6 +271,28 @@ private:
         list_node_allocator::deallocate(node);
     }
 
+    /**
+     *     配置器能一次性回收时, clear() 会把所有节点收走, 空节点改从第一级配置器
+     * 分配, 留在原地, 之前取得的 end() 不会失效
+     */
+    typedef simple_alloc<list_node, malloc_alloc> sentinel_allocator;
+
+    link_type get_sentinel()
+    {
+        return get_sentinel(typename __alloc_traits<Alloc>::has_bulk_release());
+    }
+
+    link_type get_sentinel(__false_type) { return get_node(); }
+    link_type get_sentinel(__true_type) { return sentinel_allocator::allocate(); }
+
+    void put_sentinel(link_type node)
+    {
+        put_sentinel(node, typename __alloc_traits<Alloc>::has_bulk_release());
+    }
+
+    void put_sentinel(link_type node, __false_type) { put_node(node); }
+    void put_sentinel(link_type node, __true_type) { sentinel_allocator::deallocate(node); }
+
     /**
      *     构建一个新节点并赋值
      *
@@ -253,9 +312,46 @@ private:
         put_node(node);                /* 再释放空间 */
     }
 
+    /* 逐个析构并归还节点 */
+    void clear_aux(__false_type)
+    {
+        link_type cur = static_cast<link_type>(node_->next_);
+        while (cur != node_) {
+            link_type tmp = cur;
+            cur = static_cast<link_type>(cur->next_);
+            destroy_node(tmp);
+        }
+        node_->next_ = node_;
+        node_->prev_ = node_;
+    }
+
+    /* 配置器可以一次性回收: 只析构元素, 节点一次性回收, 空节点不在其中, 原地重新连好 */
+    void clear_aux(__true_type)
+    {
+        if (empty()) {
+            return;
+        }
+        destroy_values(typename __type_traits<T>::has_trivial_destructor());
+        list_node_allocator::get_allocator().reset();
+        node_->next_ = node_;
+        node_->prev_ = node_;
+    }
+
+    void destroy_values(__true_type)
+    {
+    }
+
+    void destroy_values(__false_type)
+    {
+        for (link_type cur = static_cast<link_type>(node_->next_); cur != node_; 
+             cur = static_cast<link_type>(cur->next_)) {
+            destroy(&(cur->data_));
+        }
+    }
+
     void empty_initialize()
     {
-        node_ = get_node();             /* 空节点是尾节点的下一个节点 */
+        node_ = get_sentinel();         /* 空节点是尾节点的下一个节点 */
         node_->next_ = node_;
         node_->prev_ = node_;
     }
@@ -12,15 +12,21 @@ Copyright © wkangk <wangkangchn@163.com>
 #include <typeinfo> 
 #include <chrono> 
 #include <thread> 
+#include <vector> 
 
 #include "iterator.h"
 #include "type_traits.h"
 #include "alloc.h"
+#include "arena.h"
+#include "slab.h"
 #include "vector.h"
+#include "small_vector.h"
 #include "list.h"
 #include "deque.h"
 #include "stack.h"
 #include "queue.h"
+#include "ring_queue.h"
+#include "concurrent_queue.h"
 #include "heap.h"
 #include "priority_queue.h"
 #include "slist.h"
@@ -90,6 +96,18 @@ int main()
     }
     std::cout << std::endl;
 
+    /* 扩容时 string 是移动过去的, 字符串内容不会被拷贝 */
+    vector<std::string> words;
+    for (int i = 0; i < 5; ++i) {
+        words.emplace_back(3, char('a' + i));
+    }
+    words.insert(words.begin(), std::string("first"));
+    vector<std::string> moved(std::move(words));
+    for (auto& w : moved) {
+        std::cout << w << " ";
+    }
+    std::cout << "words.size(): " << words.size() << std::endl;
+
 
     std::cout << "list\n";
     list<int> my_list;
@@ -125,6 +143,26 @@ int main()
     }
     std::cout << std::endl;
 
+    for (int i = 18; i > 10; --i) {
+        mydeque.push_front(i);
+    }
+    mydeque.pop_front();
+    for (auto v : mydeque) {
+        std::cout << v << " ";
+    }
+    std::cout << std::endl;
+
+    /* 按段处理的算法 */
+    {
+        deque<int> big(1000, 1);
+        wkangk_stl::fill(big.begin() + 100, big.end(), 2);
+        std::cout << "sum: " << wkangk_stl::accumulate(big.begin(), big.end(), 0)
+                  << ", first 2 at: " << (wkangk_stl::find(big.begin(), big.end(), 2) - big.begin());
+        int out[5];
+        wkangk_stl::copy(mydeque.begin(), mydeque.begin() + 5, out);
+        std::cout << ", copied: " << out[0] << " " << out[4] << std::endl;
+    }
+
     /* -------------------------------------------------------------------------------
      * stack
      * ------------------------------------------------------------------------------- */
@@ -481,5 +519,443 @@ int main()
     }
     std::cout << "size: " << fshash_multimap.size() << std::endl;
 
+
+    /* -------------------------------------------------------------------------------
+     * multi_client_alloc
+     * ------------------------------------------------------------------------------- */
+    std::cout << "\n\nmulti_client_alloc" << std::endl;
+    {
+        const int thread_num = 8;
+        long sums[thread_num] = { 0 };
+        std::vector<std::thread> threads;
+        for (int t = 0; t < thread_num; ++t) {
+            threads.emplace_back([t, &sums]() {
+                for (int round = 0; round < 100; ++round) {
+                    list<int, multi_client_alloc> tlist;
+                    vector<int, multi_client_alloc> tvec;
+                    for (int i = 0; i < 100; ++i) {
+                        tlist.push_back(i);
+                        tvec.push_back(i);
+                    }
+                    for (auto v : tlist) {
+                        sums[t] += v;
+                    }
+                    for (auto v : tvec) {
+                        sums[t] += v;
+                    }
+                }
+            });
+        }
+        long total = 0;
+        for (int t = 0; t < thread_num; ++t) {
+            threads[t].join();
+            total += sums[t];
+        }
+        std::cout << "total: " << total << std::endl;   /* 8 * 100 * 2 * 4950 */
+    }
+
+
+    /* -------------------------------------------------------------------------------
+     * trim
+     * ------------------------------------------------------------------------------- */
+    std::cout << "\n\ntrim" << std::endl;
+    {
+        typedef __default_alloc_template<7> trim_alloc;     /* 单独一个实例, 不受上面容器的影响 */
+        const size_t block_num = 10000;
+        void* blocks[block_num];
+        for (size_t i = 0; i < block_num; ++i) {
+            blocks[i] = trim_alloc::allocate(32);
+        }
+        for (size_t i = 0; i < block_num; i += 2) {
+            trim_alloc::deallocate(blocks[i], 32);
+        }
+        std::cout << "half freed, released: " << trim_alloc::release_unused() << std::endl;
+        for (size_t i = 1; i < block_num; i += 2) {
+            trim_alloc::deallocate(blocks[i], 32);
+        }
+        std::cout << "all freed, released > 0: " << (trim_alloc::release_unused() > 0) << std::endl;
+        std::cout << "again, released: " << trim_alloc::release_unused() << std::endl;
+    }
+
+
+    /* -------------------------------------------------------------------------------
+     * size class
+     * ------------------------------------------------------------------------------- */
+    std::cout << "\n\nsize class" << std::endl;
+    {
+        typedef __geometric_size_class<16, 1024> geometric;
+        typedef __default_alloc_template<8, geometric> node_alloc;
+        std::cout << "classes: " << geometric::nfreelists << ", ";
+        for (size_t bytes : { 8, 100, 129, 200, 300, 1000 }) {
+            std::cout << bytes << "->" << geometric::class_bytes(geometric::index(bytes)) << " ";
+        }
+        std::cout << std::endl;
+
+        list<std::pair<int, int>, node_alloc> tlist;
+        vector<double, node_alloc> tvec;
+        for (int i = 0; i < 100; ++i) {
+            tlist.push_back(std::make_pair(i, i));
+            tvec.push_back(i);      /* 容量增长到 128 个 double, 1 KiB, 都在内存池中 */
+        }
+        std::cout << "list back: " << tlist.back().first << ", vector back: " << tvec.back() << std::endl;
+    }
+
+
+    /* -------------------------------------------------------------------------------
+     * aligned allocation
+     * ------------------------------------------------------------------------------- */
+    std::cout << "\n\naligned allocation" << std::endl;
+    {
+        struct alignas(64) padded_counter { long value; };      /* 独占一个 cache line, 避免伪共享 */
+        vector<padded_counter> counters;
+        list<padded_counter> nodes;
+        for (int i = 0; i < 10; ++i) {
+            padded_counter c;
+            c.value = i;
+            counters.push_back(c);
+            nodes.push_back(c);
+        }
+        std::cout << "vector aligned: " << ((size_t)&counters[0] % 64 == 0)
+                  << ", list aligned: " << ((size_t)&nodes.back() % 64 == 0) << std::endl;
+
+        typedef simple_alloc<int, alloc, 64> line_allocator;    /* 显式指定对齐 */
+        int* p = line_allocator::allocate(3);
+        std::cout << "simple_alloc<int, alloc, 64> aligned: " << ((size_t)p % 64 == 0) << std::endl;
+        line_allocator::deallocate(p, 3);
+    }
+
+
+    /* -------------------------------------------------------------------------------
+     * arena
+     * ------------------------------------------------------------------------------- */
+    std::cout << "\n\narena" << std::endl;
+    {
+        char buffer[1024];      /* 先用栈上的缓冲区, 不够了再向系统申请 */
+        scoped_arena request_scope(buffer, sizeof(buffer));
+        {
+            map<int, std::string, std::less<int>, arena_alloc> amap;
+            list<int, arena_alloc> alist;
+            hash_map<int, int, std::hash<int>, equal_to<int>, arena_alloc> ahashmap(10);
+            for (int i = 0; i < 100; ++i) {
+                amap.insert(std::make_pair(i, std::to_string(i)));
+                alist.push_back(i);
+                ahashmap.insert({i, i * i});
+            }
+            {
+                scoped_arena nested;    /* 嵌套的 arena, 离开作用域就整体释放 */
+                vector<int, arena_alloc> tmp;
+                for (int i = 0; i < 100; ++i) {
+                    tmp.push_back(i);
+                }
+                std::cout << "nested reserved > 0: " << (nested.get_arena().bytes_reserved() > 0) << std::endl;
+            }
+            std::cout << "amap[42]: " << amap[42] << ", alist.back(): " << alist.back() 
+                      << ", ahashmap.size(): " << ahashmap.size() << std::endl;
+        }
+        std::cout << "allocated: " << request_scope.get_arena().bytes_allocated()
+                  << "B, from system: " << request_scope.get_arena().bytes_reserved() << "B" << std::endl;
+    }
+
+
+    /* -------------------------------------------------------------------------------
+     * stateful allocator
+     * ------------------------------------------------------------------------------- */
+    std::cout << "\n\nstateful allocator" << std::endl;
+    {
+        typedef hash_map<int, int, std::hash<int>, equal_to<int>, arena_ref> shard_map;
+        arena shard0, shard1;       /* 每个分片一个 arena, 互不干扰 */
+        shard_map m0(100, std::hash<int>(), equal_to<int>(), arena_ref(shard0));
+        shard_map m1(100, std::hash<int>(), equal_to<int>(), arena_ref(shard1));
+        for (int i = 0; i < 100; ++i) {
+            m0.insert({i, i});
+        }
+        m1.insert({1, 1});
+        std::cout << "shard0 bytes > shard1 bytes: " << (shard0.bytes_allocated() > shard1.bytes_allocated()) << std::endl;
+
+        m0.swap(m1);        /* 配置器随内存一起交换 */
+        std::cout << "after swap, m1 uses shard0: " << (m1.get_allocator() == arena_ref(shard0))
+                  << ", m1.size(): " << m1.size() << std::endl;
+
+        shard_map copy(m1);   /* 拷贝时配置器也一起拷贝 */
+        std::cout << "copy uses shard0: " << (copy.get_allocator() == arena_ref(shard0))
+                  << ", sizeof(vector<int>): " << sizeof(vector<int>) << std::endl;     /* 无状态的配置器不占空间 */
+    }
+
+
+    /* -------------------------------------------------------------------------------
+     * chunk source
+     * ------------------------------------------------------------------------------- */
+    std::cout << "\n\nchunk source" << std::endl;
+    {
+        /* 内存池的 chunk 来自 2 MiB 的透明大页, 并且申请时就预先触发缺页 */
+        typedef __default_alloc_template<9, __default_size_class, __mmap_chunk_source<true, true> > huge_page_alloc;
+        {
+            hash_map<int, int, std::hash<int>, equal_to<int>, huge_page_alloc> index(1000);
+            for (int i = 0; i < 10000; ++i) {
+                index.insert({i, i});
+            }
+            huge_page_alloc::stats st = huge_page_alloc::get_stats();
+            std::cout << "index.size(): " << index.size() << ", chunks: " << st.chunks 
+                      << ", heap: " << st.heap_bytes << "B" << std::endl;
+        }
+        std::cout << "released > 0: " << (huge_page_alloc::release_unused() > 0) << std::endl;   /* munmap */
+    }
+
+
+    /* -------------------------------------------------------------------------------
+     * out of memory
+     * ------------------------------------------------------------------------------- */
+    std::cout << "\n\nout of memory" << std::endl;
+    {
+        /* 内存紧张时先把内存池中整块空闲的 chunk 还给系统 */
+        auto trim_pool = [](size_t bytes, void* ctx) -> size_t {
+            return alloc::release_unused();
+        };
+        malloc_alloc::add_pressure_callback(trim_pool, nullptr);
+        malloc_alloc::set_emergency_reserve(1 << 20);
+
+        const size_t huge = size_t(1) << 60;
+        std::cout << "try_allocate: " << malloc_alloc::try_allocate(huge) << std::endl;
+        try {
+            malloc_alloc::allocate(huge);
+        } catch (const std::bad_alloc& e) {
+            std::cout << "caught bad_alloc, reserve left: " << malloc_alloc::has_emergency_reserve() << std::endl;
+        }
+        malloc_alloc::remove_pressure_callback(trim_pool, nullptr);
+    }
+
+
+    /* -------------------------------------------------------------------------------
+     * slab
+     * ------------------------------------------------------------------------------- */
+    std::cout << "\n\nslab" << std::endl;
+    {
+        /* 节点从容器自己的 slab 中切出, clear() 时只析构元素, slab 整体回收 */
+        map<int, int> plain;
+        map<int, int, std::less<int>, slab_alloc> m;
+        for (int i = 0; i < 100000; ++i) {
+            plain.insert({i, i});
+            m.insert({i, i});
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        plain.clear();
+        auto plain_used = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        start = std::chrono::steady_clock::now();
+        m.clear();
+        auto used = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        std::cout << "clear, alloc: " << plain_used.count() << "us, slab_alloc: " << used.count() 
+                  << "us, m.size(): " << m.size() << std::endl;
+
+        for (int i = 0; i < 10; ++i) {
+            m.insert({i, i});
+        }
+        std::cout << "reuse, m.size(): " << m.size() << std::endl;
+    }
+
+
+    /* -------------------------------------------------------------------------------
+     * trivially relocatable
+     * ------------------------------------------------------------------------------- */
+    std::cout << "\n\ntrivially relocatable" << std::endl;
+    {
+        /* int 可以平凡搬迁, 扩容直接 realloc, 大块内存经常可以原地扩展 */
+        vector<int, malloc_alloc> big;
+        size_t grows = 0, in_place = 0;
+        for (int i = 0; i < (1 << 20); ++i) {
+            const int* old_start = big.begin();
+            const size_t old_capacity = big.capacity();
+            big.push_back(i);
+            if (big.capacity() != old_capacity) {
+                ++grows;
+                in_place += (old_start == big.begin());
+            }
+        }
+        std::cout << "big.size(): " << big.size() << ", grows: " << grows 
+                  << ", back: " << big.back() << ", in place: " << (in_place > 0 ? "some" : "none") << std::endl;
+    }
+
+
+    /* -------------------------------------------------------------------------------
+     * range insert
+     * ------------------------------------------------------------------------------- */
+    std::cout << "\n\nrange insert" << std::endl;
+    {
+        /* 前向迭代器先算出个数, 整段只扩容一次 */
+        std::vector<int> records(100000, 7);
+        vector<int> loaded(records.begin(), records.end());
+        int head[] = {1, 2, 3};
+        loaded.insert(loaded.begin(), head, head + 3);
+        loaded.append(head, head + 3);
+        std::cout << "size: " << loaded.size() << ", front: " << loaded.front() 
+                  << ", back: " << loaded.back() << std::endl;
+
+        loaded.assign(head, head + 2);
+        std::cout << "after assign, size: " << loaded.size() << ", capacity kept: " 
+                  << (loaded.capacity() > 100000) << std::endl;
+    }
+
+
+    /* -------------------------------------------------------------------------------
+     * default init
+     * ------------------------------------------------------------------------------- */
+    std::cout << "\n\ndefault init" << std::endl;
+    {
+        /* 缓冲区马上会被整体覆盖, 不需要先清零 */
+        vector<char> buffer(1 << 20, default_init);
+        std::fill(buffer.begin(), buffer.end(), 'x');
+        buffer.resize_uninitialized(2 << 20);
+        std::cout << "buffer.size(): " << buffer.size() << ", front: " << buffer.front() << std::endl;
+
+        vector<int> zeros;
+        zeros.resize(4);            /* 值初始化, 都是 0 */
+        std::cout << "zeros: " << zeros[0] << zeros[1] << zeros[2] << zeros[3] << std::endl;
+    }
+
+
+    /* -------------------------------------------------------------------------------
+     * simd
+     * ------------------------------------------------------------------------------- */
+    std::cout << "\n\nsimd" << std::endl;
+    {
+        /* 连续的整数区间, 查找/计数/比较/求最值都按向量处理 */
+        vector<int> samples(1 << 20, 3);
+        samples[123456] = -7;
+        samples[654321] = 42;
+        int* hit = wkangk_stl::find(samples.begin(), samples.end(), 42);
+        std::pair<int*, int*> range = wkangk_stl::minmax_element(samples.begin(), samples.end());
+        std::cout << "find 42 at: " << hit - samples.begin() 
+                  << ", count 3: " << wkangk_stl::count(samples.begin(), samples.end(), 3)
+                  << ", min: " << *range.first << ", max: " << *range.second << std::endl;
+
+        vector<int> copy(samples);
+        std::cout << "equal: " << (copy == samples);
+        copy.back() = 0;
+        std::cout << ", after change: " << (copy == samples) << std::endl;
+
+        deque<int> d1(1000, 5), d2(d1);
+        std::cout << "deque equal: " << (d1 == d2) << std::endl;
+    }
+
+
+    /* -------------------------------------------------------------------------------
+     * ring queue
+     * ------------------------------------------------------------------------------- */
+    std::cout << "\n\nring queue" << std::endl;
+    {
+        ring_queue<int> q(100);
+        std::atomic<long> sum(0);
+        std::atomic<int> taken(0);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < 2; ++t) {
+            workers.push_back(std::thread([&] {
+                int buf[8];
+                while (taken < 1000) {
+                    size_t n = q.try_pop_n(buf, 8);
+                    for (size_t i = 0; i < n; ++i) {
+                        sum += buf[i];
+                    }
+                    taken += n;
+                    if (!n) {
+                        std::this_thread::yield();
+                    }
+                }
+            }));
+        }
+        for (int i = 1; i <= 1000; ) {
+            if (q.try_push(i)) {
+                ++i;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        for (size_t i = 0; i < workers.size(); ++i) {
+            workers[i].join();
+        }
+        std::cout << "capacity: " << q.capacity() << ", sum: " << sum << std::endl;
+
+        ring_queue<std::string, spsc_tag> spsc(4);
+        spsc.try_push("hello");
+        spsc.try_emplace(3, '!');
+        std::string s1, s2;
+        spsc.try_pop(s1);
+        spsc.try_pop(s2);
+        std::cout << "spsc: " << s1 << s2 << ", empty: " << spsc.empty() << std::endl;
+    }
+
+
+    /* -------------------------------------------------------------------------------
+     * concurrent queue
+     * ------------------------------------------------------------------------------- */
+    std::cout << "\n\nconcurrent queue" << std::endl;
+    {
+        concurrent_queue<int> q;
+        std::vector<std::thread> producers;
+        for (int t = 0; t < 2; ++t) {
+            producers.push_back(std::thread([&q, t] {
+                for (int i = 1; i <= 1000; ++i) {
+                    q.push(t * 1000 + i);
+                }
+            }));
+        }
+        for (size_t i = 0; i < producers.size(); ++i) {
+            producers[i].join();
+        }
+        long sum = 0;
+        int v;
+        while (q.try_pop(v)) {
+            sum += v;
+        }
+        std::cout << "segment: " << q.segment_size() << ", sum: " << sum
+                  << ", empty: " << q.empty() << std::endl;
+    }
+
+
+    /* -------------------------------------------------------------------------------
+     * growth policy
+     * ------------------------------------------------------------------------------- */
+    std::cout << "\n\ngrowth policy" << std::endl;
+    {
+        vector<int> doubled;
+        vector<int, alloc, __golden_growth> golden;
+        vector<int, alloc, __fixed_step_growth<1000> > stepped;
+        for (int i = 0; i < 10001; ++i) {
+            doubled.push_back(i);
+            golden.push_back(i);
+            stepped.push_back(i);
+        }
+        std::cout << "capacity, 2x: " << doubled.capacity() << ", 1.5x: " << golden.capacity() 
+                  << ", step 1000: " << stepped.capacity() << std::endl;
+
+        doubled.shrink_to_fit();
+        std::cout << "after shrink_to_fit: " << doubled.capacity() << ", back: " << doubled.back() << std::endl;
+    }
+
+
+    /* -------------------------------------------------------------------------------
+     * small_vector
+     * ------------------------------------------------------------------------------- */
+    std::cout << "\n\nsmall_vector" << std::endl;
+    {
+        /* 不超过 8 个元素时不分配内存 */
+        small_vector<int, 8> small;
+        for (int i = 0; i < 8; ++i) {
+            small.push_back(i);
+        }
+        std::cout << "size: " << small.size() << ", inline: " << small.is_inline();
+        small.push_back(8);
+        std::cout << ", after push_back inline: " << small.is_inline() << ", capacity: " << small.capacity();
+        small.pop_back();
+        small.shrink_to_fit();
+        std::cout << ", after shrink_to_fit inline: " << small.is_inline() << std::endl;
+    }
+
+
+    /* -------------------------------------------------------------------------------
+     * alloc stats
+     * ------------------------------------------------------------------------------- */
+    std::cout << "\n\nalloc stats" << std::endl;
+    alloc::get_stats().dump(std::cout);
+
     return 0;
 };
\ No newline at end of file
@@ -24,6 +24,7 @@ public:
     typedef Value mapped_type;
     typedef std::pair<const key_type, data_type> value_type;    /* 整体操作和 set 一致, 只不过一个存 pair, 一个仅存数据 */
     typedef Compare key_compare;
+    typedef Alloc allocator_type;
 
     /* 比较实值, 就是转为键值 */
     class value_compare : public std::binary_function<value_type, value_type, bool>
@@ -57,6 +58,17 @@ public:
 
     multimap() : t_(Compare()) {}
     explicit multimap(const Compare& comp) : t_(comp) {}
+    multimap(const Compare& comp, const allocator_type& a) : t_(comp, a) {}
+
+    allocator_type get_allocator() const
+    {
+        return t_.get_allocator();
+    }
+
+    void swap(multimap& x)
+    {
+        t_.swap(x.t_);
+    }
 
     key_compare key_comp() const
     {
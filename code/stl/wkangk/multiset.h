@@ -24,6 +24,7 @@ public:
     typedef Key key_type;
     typedef Key value_type;
     typedef Compare key_compare;
+    typedef Alloc allocator_type;
     typedef Compare value_compare;
     typedef size_t size_type;
 
@@ -45,6 +46,7 @@ public:
 
     multiset() : t_(Compare()) {} 
     explicit multiset(const Compare& comp) : t_(comp) {} 
+    multiset(const Compare& comp, const allocator_type& a) : t_(comp, a) {}
     template <typename InputIterator>
     multiset(InputIterator first, InputIterator last) : t_(Compare())
     {   
@@ -53,6 +55,16 @@ public:
     }
 
 public:
+    allocator_type get_allocator() const
+    {
+        return t_.get_allocator();
+    }
+
+    void swap(multiset& x)
+    {
+        t_.swap(x.t_);
+    }
+
     /* 不用的就不会编译!!! */
     key_compare key_comp() const
     {
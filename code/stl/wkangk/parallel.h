@@ -0,0 +1,246 @@
+/***************************************************************
+ * @copyright  Copyright © 2026 wkangk.
+ * @file       parallel.h
+ * @author     wkangk <wangkangchn@163.com>
+ * @version    v1.0
+ * @brief      大区间构造/析构用的线程池
+ * @date       2026-10-16 20:10
+ **************************************************************/
+#ifndef __WKANGK_STL_PARALLEL_H__
+#define __WKANGK_STL_PARALLEL_H__
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+
+__WKANGK_STL_BEGIN_NAMESPACE
+
+/* -------------------------------------------------------------------------------
+ *     定义 __WKANGK_STL_PARALLEL 后, 连续区间上非平凡类型的 uninitialized_fill_n/
+ * uninitialized_copy/destroy 在元素个数达到 __WKANGK_STL_PARALLEL_THRESHOLD 时, 把区间
+ * 切成若干块交给线程池并行处理, 调用线程也处理其中一块.
+ *
+ *     元素的构造函数会在其他线程中执行, 所以打开并行时 alloc 同时切换为线程安全的
+ * multi_client_alloc(见 config.h). 正在处理块的线程(池中的线程以及 run() 的调用者)
+ * 再遇到大区间时不再并行, 直接串行处理, 不会嵌套等待.
+ * ------------------------------------------------------------------------------- */
+#ifndef __WKANGK_STL_PARALLEL_THRESHOLD
+#define __WKANGK_STL_PARALLEL_THRESHOLD (1 << 16)
+#endif
+
+class __thread_pool
+{
+public:
+    static __thread_pool& instance()
+    {
+        static __thread_pool pool;
+        return pool;
+    }
+
+    /* 包括调用线程在内, 同时干活的线程数 */
+    size_t concurrency() const
+    {
+        return workers_.size() + 1;
+    }
+
+    /* 当前线程是否正在处理块: 池中的线程, 或者在 run() 中的调用者 */
+    static bool in_worker()
+    {
+        return in_worker_flag();
+    }
+
+    /**
+     *     对 [0, chunks) 中的每个 i 调用一次 fn(i), 全部完成后返回. fn 不能抛出异常,
+     * 出错由调用者在 fn 中记录. 同一时刻只执行一个任务, 其他调用者排队.
+     *     调用者在返回之前也算作池中的线程, fn 中再遇到大区间时串行处理, 不会再次
+     * 进入 run() 等待自己持有的 run_lock_.
+     */
+    template <typename Fn>
+    void run(size_t chunks, Fn& fn)
+    {
+        std::lock_guard<std::mutex> serialize(run_lock_);
+        worker_scope scope;
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            job_.invoke = &invoke<Fn>;
+            job_.fn = &fn;
+            job_.chunks.store(chunks);
+            job_.next.store(0);
+            job_.done.store(0);
+            ++generation_;
+        }
+        wake_.notify_all();
+
+        work(job_);
+
+        /* 还要等所有进入过 work() 的线程退出, 下一个任务才能重置 job_ */
+        std::unique_lock<std::mutex> guard(lock_);
+        finished_.wait(guard, [this] { return job_.done.load() == job_.chunks.load() && active_ == 0; });
+        job_.fn = nullptr;
+    }
+
+private:
+    struct job
+    {
+        void (*invoke)(void*, size_t);
+        void* fn;
+        std::atomic<size_t> chunks;
+        std::atomic<size_t> next;       /* 下一个没人领的块 */
+        std::atomic<size_t> done;       /* 已经完成的块数 */
+    };
+
+    __thread_pool() : generation_(0), active_(0), stop_(false)
+    {
+        job_.fn = nullptr;
+        job_.chunks.store(0);
+        size_t n = std::thread::hardware_concurrency();
+        for (size_t i = 1; i < n; ++i) {
+            workers_.push_back(std::thread(&__thread_pool::worker_loop, this));
+        }
+    }
+
+    ~__thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            workers_[i].join();
+        }
+    }
+
+    __thread_pool(const __thread_pool&);
+    __thread_pool& operator=(const __thread_pool&);
+
+    /* 在作用域内把当前线程标为池中的线程, 退出时恢复 */
+    struct worker_scope
+    {
+        bool saved;
+
+        worker_scope() : saved(in_worker_flag()) { in_worker_flag() = true; }
+        ~worker_scope() { in_worker_flag() = saved; }
+    };
+
+    template <typename Fn>
+    static void invoke(void* fn, size_t i)
+    {
+        (*static_cast<Fn*>(fn))(i);
+    }
+
+    static bool& in_worker_flag()
+    {
+        static thread_local bool flag = false;
+        return flag;
+    }
+
+    /* 领块直到领完 */
+    static void work(job& j)
+    {
+        for (size_t i = j.next.fetch_add(1); i < j.chunks; i = j.next.fetch_add(1)) {
+            j.invoke(j.fn, i);
+            j.done.fetch_add(1);
+        }
+    }
+
+    void worker_loop()
+    {
+        in_worker_flag() = true;
+        size_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> guard(lock_);
+                wake_.wait(guard, [this, seen] { return stop_ || generation_ != seen; });
+                if (stop_) {
+                    return;
+                }
+                seen = generation_;
+                if (!job_.fn) {     /* 任务已经结束了 */
+                    continue;
+                }
+                ++active_;
+            }
+            work(job_);
+            {
+                std::lock_guard<std::mutex> guard(lock_);
+                --active_;
+            }
+            finished_.notify_all();
+        }
+    }
+
+private:
+    std::vector<std::thread> workers_;
+    std::mutex run_lock_;               /* 串行化 run() 的调用者 */
+    std::mutex lock_;
+    std::condition_variable wake_;      /* 有新任务 */
+    std::condition_variable finished_;  /* 任务完成 */
+    job job_;
+    size_t generation_;                 /* 每个新任务加一 */
+    size_t active_;                     /* 正在 work() 中的池线程数 */
+    bool stop_;
+};
+
+
+/* n 个元素切成几块, 小于 2 表示不值得并行 */
+inline size_t __parallel_chunks(size_t n)
+{
+    if (n < (size_t)__WKANGK_STL_PARALLEL_THRESHOLD || __thread_pool::in_worker()) {
+        return 1;
+    }
+    size_t by_size = n / ((size_t)__WKANGK_STL_PARALLEL_THRESHOLD / 4);
+    return std::min(__thread_pool::instance().concurrency(), by_size);
+}
+
+/* 第 i 块的起点, 块与块之间大小最多相差 1 */
+inline size_t __chunk_begin(size_t n, size_t chunks, size_t i)
+{
+    return n / chunks * i + std::min(i, n % chunks);
+}
+
+
+/**
+ *     把 [0, n) 切成 chunks 块, 每块调用 fn(begin, end). 某些块抛出异常时, 对每个成功的
+ * 块调用 undo(begin, end), 然后重新抛出第一个异常; 出错的块自己负责清理.
+ */
+template <typename Fn, typename Undo>
+void __parallel_chunked(size_t n, size_t chunks, Fn fn, Undo undo)
+{
+    std::unique_ptr<std::exception_ptr[]> errors(new std::exception_ptr[chunks]);
+    auto task = [&](size_t i) {
+        try {
+            fn(__chunk_begin(n, chunks, i), __chunk_begin(n, chunks, i + 1));
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    };
+    __thread_pool::instance().run(chunks, task);
+
+    size_t failed = chunks;
+    for (size_t i = 0; i < chunks; ++i) {
+        if (errors[i]) {
+            failed = i;
+            break;
+        }
+    }
+    if (failed == chunks) {
+        return;
+    }
+    for (size_t i = 0; i < chunks; ++i) {
+        if (!errors[i]) {
+            undo(__chunk_begin(n, chunks, i), __chunk_begin(n, chunks, i + 1));
+        }
+    }
+    std::rethrow_exception(errors[failed]);
+}
+
+__WKANGK_STL_END_NAMESPACE
+
+#endif	/* !__WKANGK_STL_PARALLEL_H__ */
@@ -13,6 +13,7 @@
 #include "config.h"
 #include "heap.h"
 #include "vector.h"
+#include "debug.h"
 
 
 __WKANGK_STL_BEGIN_NAMESPACE
@@ -75,6 +76,7 @@ public:
 
     void pop()
     {
+        __STL_DEBUG_CHECK(!c_.empty(), "priority_queue::pop: empty priority_queue");
         wkangk_stl::pop_heap(c_.begin(), c_.end(), comp_);
         c_.pop_back();  /* heap 相关只关心堆规则, 具体的删除要底层结构支持 */
     }
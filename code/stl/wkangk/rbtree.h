@@ -171,13 +171,13 @@ struct __rb_tree_iterator : public __rb_tree_iterator_base
  * RB tree 数据结构
  * ------------------------------------------------------------------------------- */
 template <typename Key, typename Value, class KeyOfValue, class Compare, class Alloc=alloc>
-struct my_rb_tree
+struct my_rb_tree : private __allocator<__rb_tree_node<Value>, Alloc>
 {
 private:
     typedef void* void_pointer;
     typedef __rb_tree_node_base* base_ptr;
     typedef __rb_tree_node<Value> rb_tree_node;
-    typedef simple_alloc<rb_tree_node, Alloc> rb_tree_node_allocator;   /* 节点分配器, 一次分配一个节点空间 */
+    typedef __allocator<rb_tree_node, Alloc> rb_tree_node_allocator;   /* 节点分配器, 一次分配一个节点空间 */
     typedef __rb_tree_color_type color_type;
 
 public:
@@ -192,18 +192,41 @@ public:
     typedef size_t size_type;
     typedef __rb_tree_iterator<value_type, reference, pointer> iterator;
     typedef const iterator const_iterator;
+    typedef Alloc allocator_type;
 
 public:
-    my_rb_tree(const Compare& comp=Compare()) :
-        node_count_(0), key_compare_(comp)
+    my_rb_tree(const Compare& comp=Compare(), const allocator_type& a=allocator_type()) :
+        rb_tree_node_allocator(a), node_count_(0), key_compare_(comp)
     {
         init();
     }
 
+    /* 拷贝时连同配置器一起拷贝, 按原样复制整棵树, 颜色也不变 */
+    my_rb_tree(const my_rb_tree& x) :
+        rb_tree_node_allocator(x.get_allocator()), node_count_(0), key_compare_(x.key_compare_)
+    {
+        init();
+        if (x.root() != nullptr) {
+            root() = __copy(x.root(), header_);
+            leftmost() = minimum(root());
+            rightmost() = maximum(root());
+            node_count_ = x.node_count_;
+        }
+    }
+
+    my_rb_tree& operator=(const my_rb_tree& x)
+    {
+        if (this != &x) {
+            my_rb_tree tmp(x);
+            swap(tmp);
+        }
+        return *this;
+    }
+
     ~my_rb_tree()
     {
         clear();
-        put_node(header_);
+        put_header(header_);
     }
 
 public:
@@ -266,15 +289,89 @@ public:
     void clear() 
     {
         if (node_count_ != 0) {
-            __erase(root());
-            leftmost() = header_;
-            root() = nullptr;
-            rightmost() = header_;
+            clear_aux(typename __alloc_traits<Alloc>::has_bulk_release());
             node_count_ = 0;
         }
     }   
 
+    /* 所有节点都挂在 header 上, 交换 header 即可 */
+    void swap(my_rb_tree& x)
+    {
+        std::swap(header_, x.header_);
+        std::swap(node_count_, x.node_count_);
+        std::swap(key_compare_, x.key_compare_);
+        std::swap(static_cast<rb_tree_node_allocator&>(*this), static_cast<rb_tree_node_allocator&>(x));
+    }
+
+    allocator_type get_allocator() const
+    {
+        return rb_tree_node_allocator::get_allocator();
+    }
+
 private:
+    /* 逐个析构并归还节点 */
+    void clear_aux(__false_type)
+    {
+        __erase(root());
+        leftmost() = header_;
+        root() = nullptr;
+        rightmost() = header_;
+    }
+
+    /* 配置器可以一次性回收: 只析构元素, 节点一次性回收, header 不在其中, 原地恢复成空树 */
+    void clear_aux(__true_type)
+    {
+        __destroy_values(root(), typename __type_traits<Value>::has_trivial_destructor());
+        rb_tree_node_allocator::get_allocator().reset();
+        root() = nullptr;
+        leftmost() = header_;
+        rightmost() = header_;
+    }
+
+    void __destroy_values(link_type x, __true_type)
+    {
+    }
+
+    /* 与 __erase 相同的遍历方式, 只是不归还节点 */
+    void __destroy_values(link_type x, __false_type)
+    {
+        while (x != nullptr) {
+            __destroy_values(right(x), __false_type());
+            destroy(&(x->value_field_));
+            x = left(x);
+        }
+    }
+
+    /* 复制以 x 为根的子树, 挂到 p 下面. 右子树递归, 左子树循环, 递归深度不超过树高 */
+    link_type __copy(link_type x, link_type p)
+    {
+        link_type top = clone_node(x);
+        top->parent_ = p;
+
+        try {
+            if (x->right_) {
+                top->right_ = __copy(right(x), top);
+            }
+            p = top;
+            x = left(x);
+
+            while (x != nullptr) {
+                link_type y = clone_node(x);
+                p->left_ = y;
+                y->parent_ = p;
+                if (x->right_) {
+                    y->right_ = __copy(right(x), y);
+                }
+                p = y;
+                x = left(x);
+            }
+        } catch (...) {
+            __erase(top);
+            throw;
+        }
+        return top;
+    }
+
     void  __erase(link_type x) 
     {
         while (x != 0) {
@@ -410,7 +507,7 @@ private:
 
     void init()
     {
-        header_ = get_node();
+        header_ = get_header();
         color(header_) = __rb_tree_red;     /* 总感觉这样用很别扭, 哈哈哈, 我还太嫩了 */
         root() = nullptr;
         leftmost() = header_;
@@ -429,6 +526,28 @@ private:
         return rb_tree_node_allocator::deallocate(node);
     }
 
+    /**
+     *     配置器能一次性回收时, clear() 会把所有节点收走, header 改从第一级配置器分配,
+     * 留在原地, 之前取得的 end() 不会失效
+     */
+    typedef simple_alloc<rb_tree_node, malloc_alloc> header_allocator;
+
+    link_type get_header()
+    {
+        return get_header(typename __alloc_traits<Alloc>::has_bulk_release());
+    }
+
+    link_type get_header(__false_type) { return get_node(); }
+    link_type get_header(__true_type) { return header_allocator::allocate(); }
+
+    void put_header(link_type node)
+    {
+        put_header(node, typename __alloc_traits<Alloc>::has_bulk_release());
+    }
+
+    void put_header(link_type node, __false_type) { put_node(node); }
+    void put_header(link_type node, __true_type) { header_allocator::deallocate(node); }
+
     /* 申请一个节点, 并调用构造进行初始化 */
     link_type create_node(const value_type& v)
     {
@@ -0,0 +1,495 @@
+/***************************************************************
+ * @copyright  Copyright © 2026 wkangk.
+ * @file       ring_queue.h
+ * @author     wkangk <wangkangchn@163.com>
+ * @version    v1.0
+ * @brief      无锁的有界环形队列, 多生产者多消费者以及单生产者单消费者两种
+ * @date       2026-10-16 22:10
+ **************************************************************/
+#ifndef __WKANGK_STL_RING_QUEUE_H__
+#define __WKANGK_STL_RING_QUEUE_H__
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "config.h"
+#include "alloc.h"
+#include "construct.h"
+
+__WKANGK_STL_BEGIN_NAMESPACE
+
+/* -------------------------------------------------------------------------------
+ *     queue/stack 是单线程的适配器, 线程之间传递数据时要在外面加锁. ring_queue 是
+ * 容量固定的无锁队列, 用于线程池这种每个元素都要经过一次锁的场合:
+ *
+ *     ring_queue<task*> q(1024);                   多生产者多消费者
+ *     ring_queue<task*, spsc_tag> q(1024);         只有一个生产者和一个消费者
+ *
+ *     try_push/try_pop 不阻塞, 队列满/空时返回 false; try_push_n/try_pop_n 一次处理
+ * 多个元素, 返回实际处理的个数, 整批只需要一次原子操作.
+ *     容量向上取 2 的幂, 下标用掩码计算. 头尾计数器之间按缓存行填充, 生产者和
+ * 消费者不会因为伪共享互相拖慢.
+ * ------------------------------------------------------------------------------- */
+struct mpmc_tag {};
+struct spsc_tag {};
+
+
+/* 不小于 n 的 2 的幂, 至少为 2 */
+inline size_t __ring_capacity(size_t n)
+{
+    size_t cap = 2;
+    while (cap < n) {
+        cap <<= 1;
+    }
+    return cap;
+}
+
+
+/**
+ *     多生产者多消费者. 每个槽有一个序号 seq, 对于第 pos 次写入(槽 pos & mask_):
+ *      - seq == pos        槽是空的, 生产者可以占用
+ *      - seq == pos + 1    数据已经写好, 消费者可以取走
+ *      - 消费者取走后置为 pos + capacity, 即下一圈写入时的 pos
+ * 生产者/消费者只需 CAS 推进 tail_/head_ 占住槽, 再通过 seq 发布, 互不加锁.
+ *
+ *     元素在占住槽之后才放进去, 这一步不能失败, 所以要求 T 的移动构造/移动赋值
+ * 不抛异常; try_push(const T&) 先在槽外拷贝好再移动进去. 批量的 try_push_n 直接
+ * 在槽中构造, 要求从 *first 构造 T 不抛异常(指针、句柄、POD 等).
+ *
+ * @param T         元素类型
+ * @param Mode      mpmc_tag 或 spsc_tag
+ * @param Alloc     分配槽的配置器, 只在构造/析构时使用
+ */
+template <typename T, typename Mode = mpmc_tag, typename Alloc = alloc>
+class ring_queue : private __allocator<char, Alloc>
+{
+    static_assert(std::is_nothrow_move_constructible<T>::value, "ring_queue requires a noexcept move constructor");
+    static_assert(std::is_nothrow_move_assignable<T>::value, "ring_queue requires a noexcept move assignment");
+
+    struct slot
+    {
+        std::atomic<size_t> seq;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        T* ptr() { return reinterpret_cast<T*>(&storage); }
+    };
+
+    typedef __allocator<slot, Alloc> slot_allocator;
+    typedef __allocator<char, Alloc> base_allocator;
+
+public:
+    typedef T           value_type;
+    typedef size_t      size_type;
+    typedef Alloc       allocator_type;
+
+public:
+    explicit ring_queue(size_type n, const allocator_type& a = allocator_type()) :
+        base_allocator(a), slots_(nullptr), mask_(__ring_capacity(n) - 1), head_(0), tail_(0)
+    {
+        slots_ = slot_allocator(a).allocate(capacity());
+        for (size_type i = 0; i < capacity(); ++i) {
+            new (&slots_[i].seq) std::atomic<size_t>(i);
+        }
+    }
+
+    ~ring_queue()
+    {
+        for (size_t pos = head_.load(); pos != tail_.load(); ++pos) {
+            destroy(slots_[pos & mask_].ptr());
+        }
+        slot_allocator(get_allocator()).deallocate(slots_, capacity());
+    }
+
+    allocator_type get_allocator() const
+    {
+        return static_cast<const base_allocator&>(*this).get_allocator();
+    }
+
+    size_type capacity() const
+    {
+        return mask_ + 1;
+    }
+
+    /* 其他线程同时在读写时只是一个近似值 */
+    size_type size() const
+    {
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t head = head_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /* 队列满时返回 false */
+    bool try_push(const value_type& v)
+    {
+        value_type tmp(v);      /* 拷贝可能抛异常, 在占槽之前完成 */
+        return try_push(std::move(tmp));
+    }
+
+    bool try_push(value_type&& v)
+    {
+        size_t pos;
+        slot* s = claim_for_push(pos);
+        if (!s) {
+            return false;
+        }
+        construct(s->ptr(), std::move(v));
+        s->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <typename... Args>
+    bool try_emplace(Args&&... args)
+    {
+        return try_push(value_type(std::forward<Args>(args)...));
+    }
+
+    /* 队列空时返回 false, 否则把队头元素移到 v 中 */
+    bool try_pop(value_type& v)
+    {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            slot& s = slots_[pos & mask_];
+            intptr_t dif = (intptr_t)s.seq.load(std::memory_order_acquire) - (intptr_t)(pos + 1);
+            if (dif == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    take(s, pos, v);
+                    return true;
+                }
+            } else if (dif < 0) {   /* 还没有写入 */
+                return false;
+            } else {                /* 被其他消费者抢先了 */
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     *     从 first 开始最多放入 n 个元素, 返回实际放入的个数. 一次 CAS 占住连续的
+     * 若干个空槽, 然后逐个构造并发布
+     */
+    template <typename InputIterator>
+    size_type try_push_n(InputIterator first, size_type n)
+    {
+        static_assert(std::is_nothrow_constructible<T, decltype(*first)>::value,
+                      "ring_queue::try_push_n requires constructing T from *first not to throw");
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        size_type k;
+        for (;;) {
+            k = 0;
+            while (k < n && k < capacity() &&
+                   slots_[(pos + k) & mask_].seq.load(std::memory_order_acquire) == pos + k) {
+                ++k;
+            }
+            if (k == 0) {
+                /* 第一个槽就不空: 要么满了, 要么 pos 过时了 */
+                size_t now = tail_.load(std::memory_order_relaxed);
+                if (now == pos) {
+                    return 0;
+                }
+                pos = now;
+                continue;
+            }
+            if (tail_.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        for (size_type i = 0; i < k; ++i, ++first) {
+            slot& s = slots_[(pos + i) & mask_];
+            construct(s.ptr(), *first);
+            s.seq.store(pos + i + 1, std::memory_order_release);
+        }
+        return k;
+    }
+
+    /**
+     *     最多取出 n 个元素依次赋给 *result, 返回实际取出的个数. 赋值抛出异常时 head_
+     * 已经越过了整批槽, 出错的元素和后面占住的元素都析构掉, 槽交还给生产者
+     */
+    template <typename OutputIterator>
+    size_type try_pop_n(OutputIterator result, size_type n)
+    {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        size_type k;
+        for (;;) {
+            k = 0;
+            while (k < n && k < capacity() &&
+                   slots_[(pos + k) & mask_].seq.load(std::memory_order_acquire) == pos + k + 1) {
+                ++k;
+            }
+            if (k == 0) {
+                size_t now = head_.load(std::memory_order_relaxed);
+                if (now == pos) {
+                    return 0;
+                }
+                pos = now;
+                continue;
+            }
+            if (head_.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        size_type i = 0;
+        try {
+            for (; i < k; ++i, ++result) {
+                take(slots_[(pos + i) & mask_], pos + i, *result);
+            }
+        } catch (...) {
+            for (++i; i < k; ++i) {
+                discard(slots_[(pos + i) & mask_], pos + i);
+            }
+            throw;
+        }
+        return k;
+    }
+
+private:
+    ring_queue(const ring_queue&);
+    ring_queue& operator=(const ring_queue&);
+
+    /* 占住下一个空槽, 队列满时返回 nullptr */
+    slot* claim_for_push(size_t& pos)
+    {
+        pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            slot& s = slots_[pos & mask_];
+            intptr_t dif = (intptr_t)s.seq.load(std::memory_order_acquire) - (intptr_t)pos;
+            if (dif == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    return &s;
+                }
+            } else if (dif < 0) {   /* 上一圈的元素还没被取走 */
+                return nullptr;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /* 取走槽中的元素, 把槽交给下一圈的生产者. 赋值出错时元素丢弃, 槽照样交出去 */
+    template <typename U>
+    void take(slot& s, size_t pos, U&& out)
+    {
+        try {
+            out = std::move(*s.ptr());
+        } catch (...) {
+            discard(s, pos);
+            throw;
+        }
+        discard(s, pos);
+    }
+
+    void discard(slot& s, size_t pos)
+    {
+        destroy(s.ptr());
+        s.seq.store(pos + capacity(), std::memory_order_release);
+    }
+
+private:
+    /* 只读的部分, 与两个计数器分开 */
+    slot* slots_;
+    size_t mask_;
+    char pad0_[__WKANGK_STL_CACHE_LINE];
+
+    std::atomic<size_t> head_;      /* 下一个要取的位置, 消费者推进 */
+    char pad1_[__WKANGK_STL_CACHE_LINE - sizeof(std::atomic<size_t>)];
+
+    std::atomic<size_t> tail_;      /* 下一个要写的位置, 生产者推进 */
+    char pad2_[__WKANGK_STL_CACHE_LINE - sizeof(std::atomic<size_t>)];
+};
+
+
+/**
+ *     单生产者单消费者: 只有生产者写 tail_, 只有消费者写 head_, 不需要 CAS 也不需要
+ * 每个槽的序号. 双方各自缓存一份对方的计数器, 只有看起来满/空时才去读对方的
+ * 缓存行.
+ *
+ *     元素在发布之前就构造好了, 构造失败时不发布, 所以对 T 没有额外的要求; 只有
+ * try_pop 的移动赋值要求不抛异常.
+ */
+template <typename T, typename Alloc>
+class ring_queue<T, spsc_tag, Alloc> : private __allocator<T, Alloc>
+{
+    static_assert(std::is_nothrow_move_assignable<T>::value, "ring_queue requires a noexcept move assignment");
+
+    typedef __allocator<T, Alloc> data_allocator;
+
+public:
+    typedef T           value_type;
+    typedef size_t      size_type;
+    typedef Alloc       allocator_type;
+
+public:
+    explicit ring_queue(size_type n, const allocator_type& a = allocator_type()) :
+        data_allocator(a), buffer_(nullptr), mask_(__ring_capacity(n) - 1),
+        head_(0), tail_cache_(0), tail_(0), head_cache_(0)
+    {
+        buffer_ = data_allocator::allocate(capacity());
+    }
+
+    ~ring_queue()
+    {
+        for (size_t i = head_.load(); i != tail_.load(); ++i) {
+            destroy(&buffer_[i & mask_]);
+        }
+        data_allocator::deallocate(buffer_, capacity());
+    }
+
+    allocator_type get_allocator() const
+    {
+        return data_allocator::get_allocator();
+    }
+
+    size_type capacity() const
+    {
+        return mask_ + 1;
+    }
+
+    size_type size() const
+    {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /* 以下由生产者调用 */
+    bool try_push(const value_type& v)
+    {
+        return try_emplace(v);
+    }
+
+    bool try_push(value_type&& v)
+    {
+        return try_emplace(std::move(v));
+    }
+
+    template <typename... Args>
+    bool try_emplace(Args&&... args)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (free_slots(tail, 1) == 0) {
+            return false;
+        }
+        construct(&buffer_[tail & mask_], std::forward<Args>(args)...);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* 最多放入 n 个, 全部构造好之后一次发布; 构造出错时已经构造的析构掉, 一个都不放 */
+    template <typename InputIterator>
+    size_type try_push_n(InputIterator first, size_type n)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_type k = free_slots(tail, n);
+        if (k > n) {
+            k = n;
+        }
+        size_type i = 0;
+        try {
+            for (; i < k; ++i, ++first) {
+                construct(&buffer_[(tail + i) & mask_], *first);
+            }
+        } catch (...) {
+            while (i > 0) {
+                --i;
+                destroy(&buffer_[(tail + i) & mask_]);
+            }
+            throw;
+        }
+        tail_.store(tail + k, std::memory_order_release);
+        return k;
+    }
+
+    /* 以下由消费者调用 */
+    bool try_pop(value_type& v)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (ready_slots(head, 1) == 0) {
+            return false;
+        }
+        take(head, v);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* 赋值抛出异常时只发布已经取走的元素, 出错的元素留在队头 */
+    template <typename OutputIterator>
+    size_type try_pop_n(OutputIterator result, size_type n)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_type k = ready_slots(head, n);
+        if (k > n) {
+            k = n;
+        }
+        size_type i = 0;
+        try {
+            for (; i < k; ++i, ++result) {
+                take(head + i, *result);
+            }
+        } catch (...) {
+            head_.store(head + i, std::memory_order_release);
+            throw;
+        }
+        head_.store(head + k, std::memory_order_release);
+        return k;
+    }
+
+private:
+    ring_queue(const ring_queue&);
+    ring_queue& operator=(const ring_queue&);
+
+    /* 生产者看到的空槽数, 按缓存的 head 算不够 want 个时才重新读 */
+    size_type free_slots(size_t tail, size_type want)
+    {
+        if (capacity() - (tail - head_cache_) < want) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+        }
+        return capacity() - (tail - head_cache_);
+    }
+
+    /* 消费者看到的元素个数 */
+    size_type ready_slots(size_t head, size_type want)
+    {
+        if (tail_cache_ - head < want) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+        }
+        return tail_cache_ - head;
+    }
+
+    template <typename U>
+    void take(size_t pos, U&& out)
+    {
+        T* p = &buffer_[pos & mask_];
+        out = std::move(*p);
+        destroy(p);
+    }
+
+private:
+    T* buffer_;
+    size_t mask_;
+    char pad0_[__WKANGK_STL_CACHE_LINE];
+
+    /* 消费者的缓存行 */
+    std::atomic<size_t> head_;
+    size_t tail_cache_;
+    char pad1_[__WKANGK_STL_CACHE_LINE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+    /* 生产者的缓存行 */
+    std::atomic<size_t> tail_;
+    size_t head_cache_;
+    char pad2_[__WKANGK_STL_CACHE_LINE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+};
+
+__WKANGK_STL_END_NAMESPACE
+
+#endif	/* !__WKANGK_STL_RING_QUEUE_H__ */
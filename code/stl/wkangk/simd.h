@@ -0,0 +1,624 @@
+/***************************************************************
+ * @copyright  Copyright © 2026 wkangk.
+ * @file       simd.h
+ * @author     wkangk <wangkangchn@163.com>
+ * @version    v1.0
+ * @brief      连续 POD 区间上的向量化内核
+ * @date       2026-10-16 17:30
+ **************************************************************/
+#ifndef __WKANGK_STL_SIMD_H__
+#define __WKANGK_STL_SIMD_H__
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+#include "config.h"
+#include "type_traits.h"
+
+#if !defined(__WKANGK_STL_NO_SIMD) && (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define __WKANGK_STL_SIMD_X86
+#include <immintrin.h>
+#endif
+
+
+__WKANGK_STL_BEGIN_NAMESPACE
+
+/* -------------------------------------------------------------------------------
+ *     vector/deque 的元素在内存中是连续的(deque 是一段一段连续的), 元素是整数/浮点
+ * 这样的 POD 类型时, 填充/比较/查找/计数/求最值都可以一次处理 16 或 32 个字节.
+ *
+ *     x86 上编译时同时生成 SSE2 和 AVX2 两份内核, 运行时按 CPU 支持的指令集选择
+ * (AVX2 的函数带 target("avx2"), 整个程序不需要 -mavx2); 其他平台以及定义了
+ * __WKANGK_STL_NO_SIMD 时使用标量版本.
+ *
+ *     拷贝直接交给 memmove, libc 中的 memmove 已经按 CPU 做了同样的分派.
+ *
+ *     每种操作按元素的"通道"类型分派: 相等比较只看二进制位, 所以所有 1/2/4/8 字节
+ * 的整数和指针按无符号整数处理; float/double 按浮点比较(NaN 不等于自己, 0.0 等于
+ * -0.0, 与 == 一致); 求最值要区分有无符号. 其他类型走标量版本.
+ * ------------------------------------------------------------------------------- */
+
+/* 某种大小的无符号整数 */
+template <size_t Size> struct __simd_uint { typedef void type; };
+__STL_TEMPLATE_NULL struct __simd_uint<1> { typedef uint8_t type; };
+__STL_TEMPLATE_NULL struct __simd_uint<2> { typedef uint16_t type; };
+__STL_TEMPLATE_NULL struct __simd_uint<4> { typedef uint32_t type; };
+__STL_TEMPLATE_NULL struct __simd_uint<8> { typedef uint64_t type; };
+
+/* 相等比较/填充用的通道类型, void 表示没有向量化版本 */
+template <typename T, bool = std::is_integral<T>::value || std::is_pointer<T>::value || std::is_enum<T>::value>
+struct __simd_lane
+{
+    typedef typename __simd_uint<sizeof(T)>::type type;
+};
+
+template <typename T>
+struct __simd_lane<T, false> { typedef void type; };
+
+__STL_TEMPLATE_NULL struct __simd_lane<float, false> { typedef float type; };
+__STL_TEMPLATE_NULL struct __simd_lane<double, false> { typedef double type; };
+
+/* 求最值用的通道类型, 只支持整数; Biased 为真时是无符号数, 比较前把符号位翻转 */
+template <typename T, bool = std::is_integral<T>::value && !std::is_same<T, bool>::value>
+struct __simd_order_lane
+{
+    typedef void type;
+};
+
+template <typename T>
+struct __simd_order_lane<T, true>
+{
+    typedef typename std::conditional<sizeof(T) == 1, int8_t,
+            typename std::conditional<sizeof(T) == 2, int16_t,
+            typename std::conditional<sizeof(T) == 4, int32_t, int64_t>::type>::type>::type type;
+    enum { biased = std::is_unsigned<T>::value };
+};
+
+
+#ifdef __WKANGK_STL_SIMD_X86
+
+/* 向量类型在不同的 target 之间传递时 gcc 会提示 ABI 的变化, 内核都是内联的, 不影响 */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+/* 0: 没有向量指令, 1: SSE2, 2: AVX2 */
+inline int __simd_level()
+{
+    static const int level = __builtin_cpu_supports("avx2") ? 2 :
+                             __builtin_cpu_supports("sse2") ? 1 : 0;
+    return level;
+}
+
+/* -------------------------------------------------------------------------------
+ *     一种指令集提供的基本操作, 内核只通过它们访问向量:
+ *      load/store          非对齐读写
+ *      set1(lane)          广播
+ *      eq(a, b, lane)      相等的通道对应的字节置 1 的掩码(每个字节一位)
+ *      gt(a, b, lane)      有符号比较, a > b 的通道全 1
+ *      select(m, a, b)     m 为全 1 的通道取 a, 否则取 b
+ * ------------------------------------------------------------------------------- */
+struct __sse2_ops
+{
+    typedef __m128i vec;
+    enum { bytes = 16 };
+
+    static inline vec load(const void* p) { return _mm_loadu_si128((const __m128i*)p); }
+    static inline void store(void* p, vec v) { _mm_storeu_si128((__m128i*)p, v); }
+
+    static inline vec set1(uint8_t x) { return _mm_set1_epi8((char)x); }
+    static inline vec set1(uint16_t x) { return _mm_set1_epi16((short)x); }
+    static inline vec set1(uint32_t x) { return _mm_set1_epi32((int)x); }
+    static inline vec set1(uint64_t x) { return _mm_set1_epi64x((long long)x); }
+    static inline vec set1(float x) { return _mm_castps_si128(_mm_set1_ps(x)); }
+    static inline vec set1(double x) { return _mm_castpd_si128(_mm_set1_pd(x)); }
+    static inline vec set1(int8_t x) { return _mm_set1_epi8(x); }
+    static inline vec set1(int16_t x) { return _mm_set1_epi16(x); }
+    static inline vec set1(int32_t x) { return _mm_set1_epi32(x); }
+
+    static inline unsigned eq(vec a, vec b, uint8_t) { return _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)); }
+    static inline unsigned eq(vec a, vec b, uint16_t) { return _mm_movemask_epi8(_mm_cmpeq_epi16(a, b)); }
+    static inline unsigned eq(vec a, vec b, uint32_t) { return _mm_movemask_epi8(_mm_cmpeq_epi32(a, b)); }
+    static inline unsigned eq(vec a, vec b, uint64_t)
+    {
+        /* SSE2 没有 64 位的比较, 两半都相等才算相等 */
+        unsigned m = _mm_movemask_epi8(_mm_cmpeq_epi32(a, b));
+        return ((m & 0xFF) == 0xFF ? 0xFFu : 0u) | ((m & 0xFF00) == 0xFF00 ? 0xFF00u : 0u);
+    }
+    static inline unsigned eq(vec a, vec b, float)
+    {
+        return _mm_movemask_epi8(_mm_castps_si128(_mm_cmpeq_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b))));
+    }
+    static inline unsigned eq(vec a, vec b, double)
+    {
+        return _mm_movemask_epi8(_mm_castpd_si128(_mm_cmpeq_pd(_mm_castsi128_pd(a), _mm_castsi128_pd(b))));
+    }
+
+    static inline vec gt(vec a, vec b, int8_t) { return _mm_cmpgt_epi8(a, b); }
+    static inline vec gt(vec a, vec b, int16_t) { return _mm_cmpgt_epi16(a, b); }
+    static inline vec gt(vec a, vec b, int32_t) { return _mm_cmpgt_epi32(a, b); }
+
+    static inline vec select(vec m, vec a, vec b) { return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b)); }
+    static inline vec bit_xor(vec a, vec b) { return _mm_xor_si128(a, b); }
+};
+
+#define __WKANGK_STL_AVX2 __attribute__((target("avx2")))
+
+struct __avx2_ops
+{
+    typedef __m256i vec;
+    enum { bytes = 32 };
+
+    __WKANGK_STL_AVX2 static inline vec load(const void* p) { return _mm256_loadu_si256((const __m256i*)p); }
+    __WKANGK_STL_AVX2 static inline void store(void* p, vec v) { _mm256_storeu_si256((__m256i*)p, v); }
+
+    __WKANGK_STL_AVX2 static inline vec set1(uint8_t x) { return _mm256_set1_epi8((char)x); }
+    __WKANGK_STL_AVX2 static inline vec set1(uint16_t x) { return _mm256_set1_epi16((short)x); }
+    __WKANGK_STL_AVX2 static inline vec set1(uint32_t x) { return _mm256_set1_epi32((int)x); }
+    __WKANGK_STL_AVX2 static inline vec set1(uint64_t x) { return _mm256_set1_epi64x((long long)x); }
+    __WKANGK_STL_AVX2 static inline vec set1(float x) { return _mm256_castps_si256(_mm256_set1_ps(x)); }
+    __WKANGK_STL_AVX2 static inline vec set1(double x) { return _mm256_castpd_si256(_mm256_set1_pd(x)); }
+    __WKANGK_STL_AVX2 static inline vec set1(int8_t x) { return _mm256_set1_epi8(x); }
+    __WKANGK_STL_AVX2 static inline vec set1(int16_t x) { return _mm256_set1_epi16(x); }
+    __WKANGK_STL_AVX2 static inline vec set1(int32_t x) { return _mm256_set1_epi32(x); }
+    __WKANGK_STL_AVX2 static inline vec set1(int64_t x) { return _mm256_set1_epi64x(x); }
+
+    __WKANGK_STL_AVX2 static inline unsigned eq(vec a, vec b, uint8_t) { return _mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)); }
+    __WKANGK_STL_AVX2 static inline unsigned eq(vec a, vec b, uint16_t) { return _mm256_movemask_epi8(_mm256_cmpeq_epi16(a, b)); }
+    __WKANGK_STL_AVX2 static inline unsigned eq(vec a, vec b, uint32_t) { return _mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b)); }
+    __WKANGK_STL_AVX2 static inline unsigned eq(vec a, vec b, uint64_t) { return _mm256_movemask_epi8(_mm256_cmpeq_epi64(a, b)); }
+    __WKANGK_STL_AVX2 static inline unsigned eq(vec a, vec b, float)
+    {
+        return _mm256_movemask_epi8(_mm256_castps_si256(
+                    _mm256_cmp_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b), _CMP_EQ_OQ)));
+    }
+    __WKANGK_STL_AVX2 static inline unsigned eq(vec a, vec b, double)
+    {
+        return _mm256_movemask_epi8(_mm256_castpd_si256(
+                    _mm256_cmp_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b), _CMP_EQ_OQ)));
+    }
+
+    __WKANGK_STL_AVX2 static inline vec gt(vec a, vec b, int8_t) { return _mm256_cmpgt_epi8(a, b); }
+    __WKANGK_STL_AVX2 static inline vec gt(vec a, vec b, int16_t) { return _mm256_cmpgt_epi16(a, b); }
+    __WKANGK_STL_AVX2 static inline vec gt(vec a, vec b, int32_t) { return _mm256_cmpgt_epi32(a, b); }
+    __WKANGK_STL_AVX2 static inline vec gt(vec a, vec b, int64_t) { return _mm256_cmpgt_epi64(a, b); }
+
+    __WKANGK_STL_AVX2 static inline vec select(vec m, vec a, vec b) { return _mm256_blendv_epi8(b, a, m); }
+    __WKANGK_STL_AVX2 static inline vec bit_xor(vec a, vec b) { return _mm256_xor_si256(a, b); }
+};
+
+
+/* -------------------------------------------------------------------------------
+ *     内核: 先按整个向量处理, 剩下不足一个向量的部分按原类型逐个处理. 内核总是内联
+ * 到下面带 target 的入口函数中, 所以只写一份.
+ * ------------------------------------------------------------------------------- */
+#define __WKANGK_STL_SIMD_KERNEL __attribute__((always_inline)) inline
+
+template <typename Lane, typename T>
+inline Lane __simd_bits(const T& value)
+{
+    Lane result;
+    memcpy(&result, &value, sizeof(T));
+    return result;
+}
+
+template <typename Ops, typename Lane, typename T>
+__WKANGK_STL_SIMD_KERNEL void __simd_fill_kernel(T* first, size_t n, const T& value)
+{
+    const size_t per = Ops::bytes / sizeof(T);
+    typename Ops::vec v = Ops::set1(__simd_bits<Lane>(value));
+    for (; n >= per; n -= per, first += per) {
+        Ops::store(first, v);
+    }
+    for (; n > 0; --n, ++first) {
+        *first = value;
+    }
+}
+
+template <typename Ops, typename Lane, typename T>
+__WKANGK_STL_SIMD_KERNEL bool __simd_equal_kernel(const T* first1, const T* last1, const T* first2)
+{
+    const size_t per = Ops::bytes / sizeof(T);
+    const unsigned all = (unsigned)((1ull << Ops::bytes) - 1);
+    for (; (size_t)(last1 - first1) >= per; first1 += per, first2 += per) {
+        if (Ops::eq(Ops::load(first1), Ops::load(first2), Lane()) != all) {
+            return false;
+        }
+    }
+    for (; first1 != last1; ++first1, ++first2) {
+        if (!(*first1 == *first2)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Ops, typename Lane, typename T>
+__WKANGK_STL_SIMD_KERNEL const T* __simd_find_kernel(const T* first, const T* last, const T& value)
+{
+    const size_t per = Ops::bytes / sizeof(T);
+    typename Ops::vec v = Ops::set1(__simd_bits<Lane>(value));
+    for (; (size_t)(last - first) >= per; first += per) {
+        unsigned m = Ops::eq(Ops::load(first), v, Lane());
+        if (m) {
+            return first + __builtin_ctz(m) / sizeof(T);
+        }
+    }
+    for (; first != last; ++first) {
+        if (*first == value) {
+            return first;
+        }
+    }
+    return last;
+}
+
+template <typename Ops, typename Lane, typename T>
+__WKANGK_STL_SIMD_KERNEL size_t __simd_count_kernel(const T* first, const T* last, const T& value)
+{
+    const size_t per = Ops::bytes / sizeof(T);
+    typename Ops::vec v = Ops::set1(__simd_bits<Lane>(value));
+    size_t bits = 0;    /* 相等的字节数 */
+    for (; (size_t)(last - first) >= per; first += per) {
+        bits += __builtin_popcount(Ops::eq(Ops::load(first), v, Lane()));
+    }
+    size_t result = bits / sizeof(T);
+    for (; first != last; ++first) {
+        result += (*first == value);
+    }
+    return result;
+}
+
+/* 要求区间非空. Lane 为同样大小的有符号整数, 无符号数先翻转符号位再按有符号比较 */
+template <typename Ops, typename Lane, bool Biased, typename T>
+__WKANGK_STL_SIMD_KERNEL std::pair<T, T> __simd_minmax_kernel(const T* first, const T* last)
+{
+    const size_t per = Ops::bytes / sizeof(T);
+    std::pair<T, T> result(*first, *first);
+    if ((size_t)(last - first) >= per) {
+        const typename Ops::vec bias = Ops::set1(Biased ? (Lane)((uint64_t)1 << (sizeof(T) * 8 - 1)) : (Lane)0);
+        typename Ops::vec vmin = Ops::bit_xor(Ops::load(first), bias);
+        typename Ops::vec vmax = vmin;
+        for (first += per; (size_t)(last - first) >= per; first += per) {
+            typename Ops::vec x = Ops::bit_xor(Ops::load(first), bias);
+            vmin = Ops::select(Ops::gt(vmin, x, Lane()), x, vmin);
+            vmax = Ops::select(Ops::gt(x, vmax, Lane()), x, vmax);
+        }
+        T mins[per], maxs[per];
+        Ops::store(mins, Ops::bit_xor(vmin, bias));
+        Ops::store(maxs, Ops::bit_xor(vmax, bias));
+        result.first = *std::min_element(mins, mins + per);
+        result.second = *std::max_element(maxs, maxs + per);
+    }
+    for (; first != last; ++first) {
+        if (*first < result.first) {
+            result.first = *first;
+        }
+        if (result.second < *first) {
+            result.second = *first;
+        }
+    }
+    return result;
+}
+
+
+/* -------------------------------------------------------------------------------
+ * 各指令集的入口
+ * ------------------------------------------------------------------------------- */
+template <typename Lane, typename T>
+void __simd_fill_sse2(T* first, size_t n, const T& value)
+{
+    __simd_fill_kernel<__sse2_ops, Lane>(first, n, value);
+}
+
+template <typename Lane, typename T>
+__WKANGK_STL_AVX2 void __simd_fill_avx2(T* first, size_t n, const T& value)
+{
+    __simd_fill_kernel<__avx2_ops, Lane>(first, n, value);
+}
+
+template <typename Lane, typename T>
+bool __simd_equal_sse2(const T* first1, const T* last1, const T* first2)
+{
+    return __simd_equal_kernel<__sse2_ops, Lane>(first1, last1, first2);
+}
+
+template <typename Lane, typename T>
+__WKANGK_STL_AVX2 bool __simd_equal_avx2(const T* first1, const T* last1, const T* first2)
+{
+    return __simd_equal_kernel<__avx2_ops, Lane>(first1, last1, first2);
+}
+
+template <typename Lane, typename T>
+const T* __simd_find_sse2(const T* first, const T* last, const T& value)
+{
+    return __simd_find_kernel<__sse2_ops, Lane>(first, last, value);
+}
+
+template <typename Lane, typename T>
+__WKANGK_STL_AVX2 const T* __simd_find_avx2(const T* first, const T* last, const T& value)
+{
+    return __simd_find_kernel<__avx2_ops, Lane>(first, last, value);
+}
+
+template <typename Lane, typename T>
+size_t __simd_count_sse2(const T* first, const T* last, const T& value)
+{
+    return __simd_count_kernel<__sse2_ops, Lane>(first, last, value);
+}
+
+template <typename Lane, typename T>
+__WKANGK_STL_AVX2 size_t __simd_count_avx2(const T* first, const T* last, const T& value)
+{
+    return __simd_count_kernel<__avx2_ops, Lane>(first, last, value);
+}
+
+template <typename Lane, bool Biased, typename T>
+std::pair<T, T> __simd_minmax_sse2(const T* first, const T* last, __true_type)
+{
+    return __simd_minmax_kernel<__sse2_ops, Lane, Biased>(first, last);
+}
+
+/* SSE2 没有 64 位的有符号比较 */
+template <typename Lane, bool Biased, typename T>
+std::pair<T, T> __simd_minmax_sse2(const T* first, const T* last, __false_type)
+{
+    std::pair<const T*, const T*> result = std::minmax_element(first, last);
+    return std::pair<T, T>(*result.first, *result.second);
+}
+
+template <typename Lane, bool Biased, typename T>
+__WKANGK_STL_AVX2 std::pair<T, T> __simd_minmax_avx2(const T* first, const T* last)
+{
+    return __simd_minmax_kernel<__avx2_ops, Lane, Biased>(first, last);
+}
+
+#undef __WKANGK_STL_SIMD_KERNEL
+#undef __WKANGK_STL_AVX2
+
+#pragma GCC diagnostic pop
+
+#endif  /* __WKANGK_STL_SIMD_X86 */
+
+
+/* -------------------------------------------------------------------------------
+ *     分派: 第二个参数是通道类型的指针, void* 表示没有向量化版本, 走标量
+ * ------------------------------------------------------------------------------- */
+template <typename T>
+inline void __simd_fill_aux(T* first, size_t n, const T& value, void*)
+{
+    std::fill_n(first, n, value);
+}
+
+template <typename T, typename Lane>
+inline void __simd_fill_aux(T* first, size_t n, const T& value, Lane*)
+{
+#ifdef __WKANGK_STL_SIMD_X86
+    switch (__simd_level()) {
+    case 2: __simd_fill_avx2<Lane>(first, n, value); return;
+    case 1: __simd_fill_sse2<Lane>(first, n, value); return;
+    }
+#endif
+    std::fill_n(first, n, value);
+}
+
+template <typename T>
+inline bool __simd_equal_aux(const T* first1, const T* last1, const T* first2, void*)
+{
+    return std::equal(first1, last1, first2);
+}
+
+template <typename T, typename Lane>
+inline bool __simd_equal_aux(const T* first1, const T* last1, const T* first2, Lane*)
+{
+#ifdef __WKANGK_STL_SIMD_X86
+    switch (__simd_level()) {
+    case 2: return __simd_equal_avx2<Lane>(first1, last1, first2);
+    case 1: return __simd_equal_sse2<Lane>(first1, last1, first2);
+    }
+#endif
+    return std::equal(first1, last1, first2);
+}
+
+template <typename T>
+inline const T* __simd_find_aux(const T* first, const T* last, const T& value, void*)
+{
+    return std::find(first, last, value);
+}
+
+template <typename T, typename Lane>
+inline const T* __simd_find_aux(const T* first, const T* last, const T& value, Lane*)
+{
+#ifdef __WKANGK_STL_SIMD_X86
+    switch (__simd_level()) {
+    case 2: return __simd_find_avx2<Lane>(first, last, value);
+    case 1: return __simd_find_sse2<Lane>(first, last, value);
+    }
+#endif
+    return std::find(first, last, value);
+}
+
+template <typename T>
+inline size_t __simd_count_aux(const T* first, const T* last, const T& value, void*)
+{
+    return std::count(first, last, value);
+}
+
+template <typename T, typename Lane>
+inline size_t __simd_count_aux(const T* first, const T* last, const T& value, Lane*)
+{
+#ifdef __WKANGK_STL_SIMD_X86
+    switch (__simd_level()) {
+    case 2: return __simd_count_avx2<Lane>(first, last, value);
+    case 1: return __simd_count_sse2<Lane>(first, last, value);
+    }
+#endif
+    return std::count(first, last, value);
+}
+
+template <typename T>
+inline std::pair<T, T> __simd_minmax_scalar(const T* first, const T* last)
+{
+    std::pair<const T*, const T*> result = std::minmax_element(first, last);
+    return std::pair<T, T>(*result.first, *result.second);
+}
+
+template <typename T>
+inline std::pair<T, T> __simd_minmax_aux(const T* first, const T* last, void*)
+{
+    return __simd_minmax_scalar(first, last);
+}
+
+template <typename T, typename Lane>
+inline std::pair<T, T> __simd_minmax_aux(const T* first, const T* last, Lane*)
+{
+#ifdef __WKANGK_STL_SIMD_X86
+    const bool biased = __simd_order_lane<T>::biased;
+    switch (__simd_level()) {
+    case 2:
+        return __simd_minmax_avx2<Lane, biased>(first, last);
+    case 1:
+        return __simd_minmax_sse2<Lane, biased>(first, last, typename __bool_type<(sizeof(T) < 8)>::type());
+    }
+#endif
+    return __simd_minmax_scalar(first, last);
+}
+
+
+/* -------------------------------------------------------------------------------
+ * 供容器和用户使用的接口, 参数都是连续区间
+ * ------------------------------------------------------------------------------- */
+/* 用 value 填充 n 个已经构造好(或者是 POD)的元素 */
+template <typename T>
+inline T* __simd_fill_n(T* first, size_t n, const T& value)
+{
+    __simd_fill_aux(first, n, value, (typename __simd_lane<T>::type*)0);
+    return first + n;
+}
+
+/* 按二进制拷贝, 区间可以重叠 */
+template <typename T>
+inline T* __simd_copy(const T* first, const T* last, T* result)
+{
+    memmove(result, first, (last - first) * sizeof(T));
+    return result + (last - first);
+}
+
+template <typename T>
+inline bool __simd_equal(const T* first1, const T* last1, const T* first2)
+{
+    return __simd_equal_aux(first1, last1, first2, (typename __simd_lane<T>::type*)0);
+}
+
+/* 第一个等于 value 的元素, 没有时返回 last */
+template <typename T>
+inline const T* __simd_find(const T* first, const T* last, const T& value)
+{
+    return __simd_find_aux(first, last, value, (typename __simd_lane<T>::type*)0);
+}
+
+template <typename T>
+inline size_t __simd_count(const T* first, const T* last, const T& value)
+{
+    return __simd_count_aux(first, last, value, (typename __simd_lane<T>::type*)0);
+}
+
+/* 区间非空, 返回最小值和最大值 */
+template <typename T>
+inline std::pair<T, T> __simd_minmax(const T* first, const T* last)
+{
+    return __simd_minmax_aux(first, last, (typename __simd_order_lane<T>::type*)0);
+}
+
+
+/* 要找的值与元素类型不同时按 std 的语义逐个用 == 比较, 不先转换成元素类型 */
+template <typename T, typename U>
+inline T* __find_aux(T* first, T* last, const U& value, __false_type)
+{
+    return std::find(first, last, value);
+}
+
+template <typename T, typename U>
+inline T* __find_aux(T* first, T* last, const U& value, __true_type)
+{
+    typedef typename std::remove_const<T>::type value_type;
+    return const_cast<T*>(__simd_find<value_type>(first, last, value));
+}
+
+template <typename T, typename U>
+inline size_t __count_aux(const T* first, const T* last, const U& value, __false_type)
+{
+    return std::count(first, last, value);
+}
+
+template <typename T, typename U>
+inline size_t __count_aux(const T* first, const T* last, const U& value, __true_type)
+{
+    return __simd_count<T>(first, last, value);
+}
+
+
+/**
+ *     连续区间上的查找/计数/比较/求最值, 用法与 std 中的同名算法相同,
+ * 可以直接传 vector/small_vector 的迭代器或者数组指针. 查找/计数的值与元素
+ * 类型相同时才向量化.
+ */
+template <typename T, typename U>
+inline T* find(T* first, T* last, const U& value)
+{
+    typedef typename std::remove_const<T>::type value_type;
+    typedef typename __bool_type<std::is_same<value_type, U>::value>::type same_type;
+    return __find_aux(first, last, value, same_type());
+}
+
+template <typename T, typename U>
+inline size_t count(const T* first, const T* last, const U& value)
+{
+    typedef typename __bool_type<std::is_same<T, U>::value>::type same_type;
+    return __count_aux(first, last, value, same_type());
+}
+
+template <typename T>
+inline bool equal(const T* first1, const T* last1, const T* first2)
+{
+    return __simd_equal<T>(first1, last1, first2);
+}
+
+/**
+ *     整数先向量化求出最小值和最大值, 再找第一个最小值和最后一个最大值的位置.
+ * 整数的 == 与 < 一致, 两个值一定能找到
+ */
+template <typename T>
+inline std::pair<T*, T*> __minmax_element_aux(T* first, T* last, __true_type)
+{
+    if (first == last) {
+        return std::pair<T*, T*>(last, last);
+    }
+    typedef typename std::remove_const<T>::type value_type;
+    std::pair<value_type, value_type> values = __simd_minmax<value_type>(first, last);
+    T* max_pos = last - 1;
+    while (!(*max_pos == values.second)) {
+        --max_pos;
+    }
+    return std::pair<T*, T*>(find(first, last, values.first), max_pos);
+}
+
+/* 浮点数(NaN 与谁都不相等)和其他类型只要求 <, 直接用 std 的版本 */
+template <typename T>
+inline std::pair<T*, T*> __minmax_element_aux(T* first, T* last, __false_type)
+{
+    return std::minmax_element(first, last);
+}
+
+/* 第一个最小的元素和最后一个最大的元素, 与 std::minmax_element 相同 */
+template <typename T>
+inline std::pair<T*, T*> minmax_element(T* first, T* last)
+{
+    typedef typename std::remove_const<T>::type value_type;
+    typedef typename __bool_type<!std::is_void<typename __simd_order_lane<value_type>::type>::value>::type integral;
+    return __minmax_element_aux(first, last, integral());
+}
+
+__WKANGK_STL_END_NAMESPACE
+
+#endif	/* !__WKANGK_STL_SIMD_H__ */
@@ -0,0 +1,332 @@
+/***************************************************************
+ * @copyright  Copyright © 2026 wkangk.
+ * @file       slab.h
+ * @author     wkangk <wangkangchn@163.com>
+ * @version    v1.0
+ * @brief      节点容器专用的 slab 配置器
+ * @date       2026-10-16 15:20
+ **************************************************************/
+#ifndef __WKANGK_STL_SLAB_H__
+#define __WKANGK_STL_SLAB_H__
+#include "alloc.h"
+
+__WKANGK_STL_BEGIN_NAMESPACE
+
+/* -------------------------------------------------------------------------------
+ *     list/slist/my_rb_tree/hash_table 每个元素都分配一个大小固定的节点. slab_alloc
+ * 是有状态的配置器, 每个容器持有自己的一份, 节点从连续的 slab 中切出, 归还的节点
+ * 串在侵入式的 free list 上.
+ *
+ *     节点在内存中挨在一起, 遍历时局部性更好; 更重要的是 clear() 时容器只需析构
+ * 元素, 然后 reset() 把所有 slab 一次性还回去: 销毁一个 1000 万元素的 map 只有
+ * 几百次 free, 而不是 1000 万次归还.
+ *
+ *     一个实例最多管理 NSizes 种大小(容器一般只有节点一种), 超出的种类、大于
+ * __SLAB_MAX_BYTES 的请求以及超过 __ALIGN 对齐的请求交给第一级配置器. 这些大块前面
+ * 加一个头串成链表, reset()/release() 时与 slab 一起释放.
+ *
+ *     拷贝得到的是一个空的 slab_alloc(容器拷贝时各用各的内存), 移动则把 slab 一起
+ * 带走(容器交换时内存跟着配置器走).
+ *     它只适合配置器始终保存在容器中的节点容器和 vector; deque 的 map 是由临时的
+ * 配置器分配的, 不能使用.
+ * ------------------------------------------------------------------------------- */
+template <size_t NSizes = 4>
+class __slab_alloc_template
+{
+public:
+    enum { __SLAB_MAX_BYTES = 1024 };         /* 更大的请求不走 slab */
+    enum { __FIRST_SLAB = 4096 };             /* 第一块 slab 的大小, 之后每次翻倍 */
+    enum { __MAX_SLAB = 1 << 20 };            /* slab 最大 1 MiB */
+
+    __slab_alloc_template() : bigs_(nullptr)
+    {
+        memset(pools_, 0, sizeof(pools_));
+    }
+
+    __slab_alloc_template(const __slab_alloc_template&) : bigs_(nullptr)
+    {
+        memset(pools_, 0, sizeof(pools_));
+    }
+
+    __slab_alloc_template(__slab_alloc_template&& x) : bigs_(x.bigs_)
+    {
+        memcpy(pools_, x.pools_, sizeof(pools_));
+        memset(x.pools_, 0, sizeof(x.pools_));
+        x.bigs_ = nullptr;
+    }
+
+    __slab_alloc_template& operator=(__slab_alloc_template&& x)
+    {
+        if (this != &x) {
+            release();
+            memcpy(pools_, x.pools_, sizeof(pools_));
+            memset(x.pools_, 0, sizeof(x.pools_));
+            bigs_ = x.bigs_;
+            x.bigs_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~__slab_alloc_template()
+    {
+        release();
+    }
+
+    void* allocate(size_t bytes)
+    {
+        size_pool* pool = find_pool(bytes, true);
+        if (!pool) {
+            return allocate_big(bytes, 0);
+        }
+
+        obj* result = pool->free_list;
+        if (result) {
+            pool->free_list = result->next;
+            return result;
+        }
+        if (!pool->cur || pool->cur + pool->bytes > pool->end) {
+            new_slab(pool);
+        }
+        result = (obj*)pool->cur;
+        pool->cur += pool->bytes;
+        return result;
+    }
+
+    void deallocate(void* p, size_t bytes)
+    {
+        size_pool* pool = find_pool(bytes, false);
+        if (!pool) {
+            deallocate_big(p);
+            return;
+        }
+        ((obj*)p)->next = pool->free_list;
+        pool->free_list = (obj*)p;
+    }
+
+    void* allocate_aligned(size_t bytes, size_t align)
+    {
+        if (align <= __ALIGN) {
+            return allocate(bytes);
+        }
+        return allocate_big(bytes, align);
+    }
+
+    void deallocate_aligned(void* p, size_t bytes, size_t align)
+    {
+        if (align <= __ALIGN) {
+            deallocate(p, bytes);
+            return;
+        }
+        deallocate_big(p);
+    }
+
+    /**
+     *     一次性回收所有分配出去的节点, 之前分配的内存全部失效. 每种大小保留最大的
+     * 一块 slab 供之后使用, 其余的还给系统, 交给第一级配置器的大块全部释放.
+     */
+    void reset()
+    {
+        free_bigs();
+        for (size_t i = 0; i < NSizes; ++i) {
+            size_pool& pool = pools_[i];
+            if (!pool.slabs) {
+                continue;
+            }
+            slab* keep = pool.slabs;        /* 头插的, 第一块就是最大的 */
+            free_slabs(keep->next);
+            keep->next = nullptr;
+            pool.free_list = nullptr;
+            pool.cur = slab_data(keep);
+            pool.end = (char*)keep + keep->size;
+            pool.next_slab = keep->size * 2 > __MAX_SLAB ? (size_t)__MAX_SLAB : keep->size * 2;
+        }
+    }
+
+    /* 所有 slab 和大块都还给系统 */
+    void release()
+    {
+        free_bigs();
+        for (size_t i = 0; i < NSizes; ++i) {
+            free_slabs(pools_[i].slabs);
+            size_t bytes = pools_[i].bytes;
+            memset(&pools_[i], 0, sizeof(size_pool));
+            pools_[i].bytes = bytes;    /* 大小保留, 之前交给第一级配置器的同样大小的内存归还时才不会放错地方 */
+        }
+    }
+
+    /* 向系统申请的 slab 总字节数 */
+    size_t bytes_reserved() const
+    {
+        size_t result = 0;
+        for (size_t i = 0; i < NSizes; ++i) {
+            for (slab* cur = pools_[i].slabs; cur; cur = cur->next) {
+                result += cur->size;
+            }
+        }
+        return result;
+    }
+
+private:
+    __slab_alloc_template& operator=(const __slab_alloc_template&);
+
+    union obj
+    {
+        obj* next;
+        char client_data[1];
+    };
+
+    struct slab
+    {
+        slab* next;
+        size_t size;            /* 包括 slab 头在内的大小 */
+    };
+    enum { __SLAB_HEADER = (sizeof(slab) + __ALIGN-1) & ~(__ALIGN-1) };
+
+    /* 交给第一级配置器的大块, 头紧挨在返回给用户的地址前面 */
+    struct big
+    {
+        big* prev;
+        big* next;
+        size_t bytes;           /* 包括头在内的大小 */
+        size_t align;           /* 0 表示用 allocate 分配的 */
+    };
+
+    /* 头占的字节数: sizeof(big) 是 16 的倍数, align 是 2 的幂, 取大的那个, 用户拿到的
+    地址仍然按 malloc 的 16 字节或者 align 对齐 */
+    static size_t big_header(size_t align)
+    {
+        return align > sizeof(big) ? align : sizeof(big);
+    }
+
+    /* 一种大小的节点 */
+    struct size_pool
+    {
+        size_t bytes;           /* 0 表示还没有使用 */
+        obj* free_list;
+        slab* slabs;            /* 头插, 第一块是最新也是最大的 */
+        char* cur;              /* 当前 slab 中未切分部分的起点 */
+        char* end;
+        size_t next_slab;       /* 下一块 slab 的大小 */
+    };
+
+    static size_t ROUND_UP(size_t bytes)
+    {
+        return (bytes + __ALIGN-1) & ~(__ALIGN-1);
+    }
+
+    static char* slab_data(slab* s)
+    {
+        return (char*)s + __SLAB_HEADER;
+    }
+
+    /* 找到 bytes 对应的 size_pool, create 为真时可以占用一个空位 */
+    size_pool* find_pool(size_t bytes, bool create)
+    {
+        if (bytes > __SLAB_MAX_BYTES) {
+            return nullptr;
+        }
+        bytes = ROUND_UP(bytes);
+        for (size_t i = 0; i < NSizes; ++i) {
+            if (pools_[i].bytes == bytes) {
+                return pools_ + i;
+            }
+            if (pools_[i].bytes == 0) {
+                if (!create) {
+                    return nullptr;
+                }
+                pools_[i].bytes = bytes;
+                return pools_ + i;
+            }
+        }
+        return nullptr;
+    }
+
+    void new_slab(size_pool* pool)
+    {
+        size_t size = pool->next_slab ? pool->next_slab : (size_t)__FIRST_SLAB;
+        size = std::max(size, __SLAB_HEADER + pool->bytes);
+        slab* s = (slab*)malloc_alloc::allocate(size);
+        s->size = size;
+        s->next = pool->slabs;
+        pool->slabs = s;
+        pool->cur = slab_data(s);
+        pool->end = (char*)s + size;
+        pool->next_slab = size * 2 > __MAX_SLAB ? std::max(size, (size_t)__MAX_SLAB) : size * 2;
+    }
+
+    void* allocate_big(size_t bytes, size_t align)
+    {
+        size_t header = big_header(align);
+        char* raw = (char*)(align ? malloc_alloc::allocate_aligned(header + bytes, align)
+                                  : malloc_alloc::allocate(header + bytes));
+        big* b = (big*)(raw + header - sizeof(big));
+        b->bytes = header + bytes;
+        b->align = align;
+        b->prev = nullptr;
+        b->next = bigs_;
+        if (bigs_) {
+            bigs_->prev = b;
+        }
+        bigs_ = b;
+        return raw + header;
+    }
+
+    void deallocate_big(void* p)
+    {
+        big* b = (big*)p - 1;
+        if (b->prev) {
+            b->prev->next = b->next;
+        } else {
+            bigs_ = b->next;
+        }
+        if (b->next) {
+            b->next->prev = b->prev;
+        }
+        free_big(b);
+    }
+
+    static void free_big(big* b)
+    {
+        char* raw = (char*)(b + 1) - big_header(b->align);
+        if (b->align) {
+            malloc_alloc::deallocate_aligned(raw, b->bytes, b->align);
+        } else {
+            malloc_alloc::deallocate(raw, b->bytes);
+        }
+    }
+
+    void free_bigs()
+    {
+        while (bigs_) {
+            big* next = bigs_->next;
+            free_big(bigs_);
+            bigs_ = next;
+        }
+    }
+
+    static void free_slabs(slab* s)
+    {
+        while (s) {
+            slab* next = s->next;
+            malloc_alloc::deallocate(s, s->size);
+            s = next;
+        }
+    }
+
+private:
+    size_pool pools_[NSizes];
+    big* bigs_;                 /* 交给第一级配置器的大块 */
+};
+
+template <size_t NSizes>
+struct __alloc_traits<__slab_alloc_template<NSizes> >
+{
+    typedef __true_type has_bulk_release;
+};
+
+
+typedef __slab_alloc_template<> slab_alloc;
+
+__WKANGK_STL_END_NAMESPACE
+
+#endif	/* !__WKANGK_STL_SLAB_H__ */
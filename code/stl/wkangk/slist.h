@@ -10,6 +10,7 @@
 #define __WKANGK_STL_SLIST_HPP__ 
 #include "iterator.h"
 #include "alloc.h"
+#include "debug.h"
 
 __WKANGK_STL_BEGIN_NAMESPACE
 
@@ -148,7 +149,7 @@ inline __slist_node_base* __slist_make_link(__slist_node_base* head, __slist_nod
 inline size_t __slist_size(__slist_node_base* node)
 {
     size_t size = 0;
-    for (; node->next_ != nullptr; node = node->next_) {
+    for (; node != nullptr; node = node->next_) {    /* 从 node 开始数, 空链表时 node 为 nullptr */
         ++size;
     }
     return size;
@@ -156,7 +157,7 @@ inline size_t __slist_size(__slist_node_base* node)
 
 
 template <typename T, typename Alloc=alloc>
-class slist
+class slist : private __allocator<__slist_node<T>, Alloc>
 {
 public:
     typedef T   value_type;
@@ -166,6 +167,7 @@ public:
     typedef const reference const_reference;
     typedef size_t size_type;
     typedef ptrdiff_t difference_type;
+    typedef Alloc allocator_type;
 
     typedef __slist_iterator<value_type, reference, pointer> iterator;
     typedef __slist_iterator<value_type, const_reference, const_pointer> const_iterator;
@@ -174,7 +176,7 @@ private:
     typedef __slist_node<value_type> list_node;     /* 都是直接绑定的 */
     typedef __slist_node_base list_node_base;
     typedef __slist_iterator_base iterator_base;
-    typedef simple_alloc<list_node, Alloc>  list_node_allocator;
+    typedef __allocator<list_node, Alloc>  list_node_allocator;
 
 public:
     slist() 
@@ -182,6 +184,30 @@ public:
         head_.next_ = nullptr; /* nullptr 标识链接的结尾 */
     }
 
+    explicit slist(const allocator_type& a) : list_node_allocator(a)
+    {
+        head_.next_ = nullptr;
+    }
+
+    /* 拷贝时连同配置器一起拷贝 */
+    slist(const slist& x) : list_node_allocator(x.get_allocator())
+    {
+        head_.next_ = nullptr;
+        list_node_base* prev = &head_;  /* 一直接在尾部, 保持原来的顺序 */
+        for (list_node_base* cur = x.head_.next_; cur; cur = cur->next_) {
+            prev = __slist_make_link(prev, create_node(static_cast<list_node*>(cur)->data_));
+        }
+    }
+
+    slist& operator=(const slist& x)
+    {
+        if (this != &x) {
+            slist tmp(x);
+            swap(tmp);
+        }
+        return *this;
+    }
+
     ~slist()
     {
         clear();
@@ -211,6 +237,7 @@ public:
 
     reference front()
     {
+        __STL_DEBUG_CHECK(!empty(), "slist::front: empty slist");
         return static_cast<list_node*>(head_.next_)->data_;
     }
 
@@ -221,20 +248,60 @@ public:
 
     void pop_front()
     {
+        __STL_DEBUG_CHECK(!empty(), "slist::pop_front: empty slist");
         list_node* node = static_cast<list_node*>(head_.next_);
         head_.next_ = head_.next_->next_;
         destroy_node(node);
     }
 
     void clear()
+    {
+        clear_aux(typename __alloc_traits<Alloc>::has_bulk_release());
+    }
+
+    void swap(slist& x)
+    {
+        std::swap(head_.next_, x.head_.next_);
+        std::swap(static_cast<list_node_allocator&>(*this), static_cast<list_node_allocator&>(x));
+    }
+
+    allocator_type get_allocator() const
+    {
+        return list_node_allocator::get_allocator();
+    }
+
+private:
+    void clear_aux(__false_type)
     {
         while (!empty()) {
             pop_front();
         }
     }
 
-private:
-    static list_node* create_node(const value_type& val)
+    /* 配置器可以一次性回收: 只析构元素, 节点一起回收 */
+    void clear_aux(__true_type)
+    {
+        if (empty()) {
+            return;
+        }
+        destroy_values(typename __type_traits<T>::has_trivial_destructor());
+        head_.next_ = nullptr;
+        list_node_allocator::get_allocator().reset();
+    }
+
+    void destroy_values(__true_type)
+    {
+    }
+
+    void destroy_values(__false_type)
+    {
+        for (list_node_base* cur = head_.next_; cur; cur = cur->next_) {
+            destroy(&static_cast<list_node*>(cur)->data_);
+        }
+    }
+
+    /* 节点从配置器的实例中分配, 所以不再是静态函数 */
+    list_node* create_node(const value_type& val)
     {
         list_node* node = list_node_allocator::allocate();
         construct(&node->data_, val);
@@ -242,7 +309,7 @@ private:
         return node;
     }
 
-    static void destroy_node(list_node* node)
+    void destroy_node(list_node* node)
     {
         destroy(&node->data_);
         list_node_allocator::deallocate(node);
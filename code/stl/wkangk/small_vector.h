@@ -0,0 +1,584 @@
+/***************************************************************
+ * @copyright  Copyright © 2026 wkangk.
+ * @file       small_vector.h
+ * @author     wkangk <wangkangchn@163.com>
+ * @version    v1.0
+ * @brief      带内联缓冲区的 vector
+ * @date       2026-10-16 16:40
+ **************************************************************/
+#ifndef __WKANGK_STL_SMALL_VECTOR_H__
+#define __WKANGK_STL_SMALL_VECTOR_H__
+#include <type_traits>
+
+#include "config.h"
+#include "construct.h"
+#include "alloc.h"
+#include "uninitialized.h"
+#include "debug.h"
+#include "vector.h"
+
+
+__WKANGK_STL_BEGIN_NAMESPACE
+
+/* -------------------------------------------------------------------------------
+ *     热路径上很多集合只有 0~8 个元素, vector 哪怕只放一个元素也要向配置器申请内存.
+ * small_vector 在对象内部留出 N 个元素的空间, 元素个数不超过 N 时不分配内存, 超过
+ * 以后才和 vector 一样从配置器申请, 并按 GrowthPolicy 扩容.
+ *
+ *     接口与 vector 相同. 不同之处在于: 元素在内联缓冲区中时, 移动/交换要逐个移动
+ * 元素, 迭代器也会失效; sizeof(small_vector) 包含了 N 个元素的空间.
+ * ------------------------------------------------------------------------------- */
+template <typename T, size_t N, typename Alloc = alloc, typename GrowthPolicy = __double_growth>
+class small_vector : private __allocator<T, Alloc>
+{
+    static_assert(N > 0, "small_vector needs at least one inline element, use vector instead");
+
+public:
+    typedef T               value_type;
+    typedef value_type*     pointer;
+    typedef value_type*     iterator;
+    typedef const value_type*   const_iterator;
+
+    typedef value_type&     reference;
+    typedef const value_type&   const_reference;
+    typedef size_t          size_type;
+    typedef ptrdiff_t       difference_type;
+    typedef Alloc           allocator_type;
+
+public:
+    small_vector() : start_(inline_start()), finish_(start_), end_of_storage_(start_ + N) {}
+
+    explicit small_vector(const allocator_type& a) :
+        data_allocator(a), start_(inline_start()), finish_(start_), end_of_storage_(start_ + N)
+    {
+    }
+
+    explicit small_vector(size_type n, const value_type& value = value_type(),
+                          const allocator_type& a = allocator_type()) :
+        data_allocator(a), start_(inline_start()), finish_(start_), end_of_storage_(start_ + N)
+    {
+        try {
+            insert(end(), n, value);
+        } catch (...) {
+            abandon();
+            throw;
+        }
+    }
+
+    template <typename InputIterator>
+    small_vector(InputIterator first, InputIterator last, const allocator_type& a = allocator_type()) :
+        data_allocator(a), start_(inline_start()), finish_(start_), end_of_storage_(start_ + N)
+    {
+        try {
+            insert(end(), first, last);
+        } catch (...) {
+            abandon();
+            throw;
+        }
+    }
+
+    /* 拷贝时连同配置器一起拷贝 */
+    small_vector(const small_vector& x) :
+        data_allocator(x.get_allocator()), start_(inline_start()), finish_(start_), end_of_storage_(start_ + N)
+    {
+        reserve(x.size());
+        try {
+            finish_ = wkangk_stl::uninitialized_copy(x.begin(), x.end(), start_);
+        } catch (...) {
+            abandon();
+            throw;
+        }
+    }
+
+    small_vector(small_vector&& x) :
+        data_allocator(std::move(static_cast<data_allocator&>(x))),
+        start_(inline_start()), finish_(start_), end_of_storage_(start_ + N)
+    {
+        steal(x);
+    }
+
+    small_vector& operator=(const small_vector& x)
+    {
+        if (this != &x) {
+            small_vector tmp(x);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    small_vector& operator=(small_vector&& x)
+    {
+        if (this != &x) {
+            clear();
+            deallocate();
+            static_cast<data_allocator&>(*this) = std::move(static_cast<data_allocator&>(x));
+            steal(x);
+        }
+        return *this;
+    }
+
+    ~small_vector()
+    {
+        abandon();
+    }
+
+public:
+    iterator begin() { return start_; }
+    iterator end() { return finish_; }
+    const_iterator begin() const { return start_; }
+    const_iterator end() const { return finish_; }
+    size_type size() const { return static_cast<size_type>(finish_ - start_); }
+    size_type capacity() const { return static_cast<size_type>(end_of_storage_ - start_); }
+    bool empty() const { return finish_ == start_; }
+
+    /* 元素是否还在内联缓冲区中 */
+    bool is_inline() const { return start_ == inline_start(); }
+
+    reference operator[](size_type n)
+    {
+        __STL_DEBUG_CHECK(n < size(), "small_vector::operator[]: index out of range");
+        return *(begin() + n);
+    }
+    const_reference operator[](size_type n) const
+    {
+        __STL_DEBUG_CHECK(n < size(), "small_vector::operator[]: index out of range");
+        return *(begin() + n);
+    }
+    reference front()
+    {
+        __STL_DEBUG_CHECK(!empty(), "small_vector::front: empty small_vector");
+        return *begin();
+    }
+    const_reference front() const
+    {
+        __STL_DEBUG_CHECK(!empty(), "small_vector::front: empty small_vector");
+        return *begin();
+    }
+    reference back()
+    {
+        __STL_DEBUG_CHECK(!empty(), "small_vector::back: empty small_vector");
+        return *(end() - 1);
+    }
+    const_reference back() const
+    {
+        __STL_DEBUG_CHECK(!empty(), "small_vector::back: empty small_vector");
+        return *(end() - 1);
+    }
+
+    void push_back(const value_type& value)
+    {
+        emplace_back(value);
+    }
+
+    void push_back(value_type&& value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    template <typename... Args>
+    void emplace_back(Args&&... args)
+    {
+        if (finish_ != end_of_storage_) {
+            construct(finish_, std::forward<Args>(args)...);
+        } else {
+            /* 参数可能引用容器中的元素, 扩容前先构造出来 */
+            value_type value_copy(std::forward<Args>(args)...);
+            grow(next_capacity(size() + 1));
+            construct(finish_, std::move(value_copy));
+        }
+        ++finish_;
+    }
+
+    template <typename... Args>
+    iterator emplace(iterator position, Args&&... args)
+    {
+        __STL_DEBUG_CHECK(owns(position), "small_vector::insert: iterator does not belong to this small_vector");
+        const size_type n = position - begin();
+        if (position == end()) {
+            emplace_back(std::forward<Args>(args)...);
+            return begin() + n;
+        }
+
+        value_type value_copy(std::forward<Args>(args)...);
+        if (finish_ == end_of_storage_) {
+            grow(next_capacity(size() + 1));
+            position = begin() + n;
+        }
+        construct(finish_, std::move(*(finish_ - 1)));
+        ++finish_;
+        std::move_backward(position, finish_ - 2, finish_ - 1);
+        *position = std::move(value_copy);
+        return position;
+    }
+
+    iterator insert(iterator position, const value_type& value)
+    {
+        return emplace(position, value);
+    }
+
+    iterator insert(iterator position, value_type&& value)
+    {
+        return emplace(position, std::move(value));
+    }
+
+    void insert(iterator position, size_type n, const value_type& value);
+
+    /* 前向迭代器只检查一次容量, 与 vector 相同 */
+    template <typename InputIterator>
+    void insert(iterator position, InputIterator first, InputIterator last)
+    {
+        __STL_DEBUG_CHECK(owns(position), "small_vector::insert: iterator does not belong to this small_vector");
+        typedef typename __is_integer<InputIterator>::integral integral;
+        insert_dispatch(position, first, last, integral());
+    }
+
+    template <typename InputIterator>
+    void append(InputIterator first, InputIterator last)
+    {
+        insert(end(), first, last);
+    }
+
+    void assign(size_type n, const value_type& value)
+    {
+        clear();
+        insert(end(), n, value);
+    }
+
+    template <typename InputIterator>
+    void assign(InputIterator first, InputIterator last)
+    {
+        clear();
+        insert(end(), first, last);
+    }
+
+    void pop_back()
+    {
+        __STL_DEBUG_CHECK(!empty(), "small_vector::pop_back: empty small_vector");
+        --finish_;
+        destroy(finish_);
+    }
+
+    iterator erase(iterator position)
+    {
+        __STL_DEBUG_CHECK(owns(position) && position != end(), "small_vector::erase: iterator is not dereferenceable");
+        if (position + 1 != end()) {
+            std::move(position + 1, end(), position);
+        }
+        --finish_;
+        destroy(finish_);
+        return position;
+    }
+
+    iterator erase(iterator first, iterator last)
+    {
+        __STL_DEBUG_CHECK(owns(first) && owns(last) && first <= last, "small_vector::erase: invalid range");
+        iterator it = std::move(last, end(), first);
+        destroy(it, finish_);
+        finish_ = it;
+        return first;
+    }
+
+    void clear()
+    {
+        erase(begin(), end());
+    }
+
+    /* 两边都在堆上时只交换指针, 否则借助移动完成 */
+    void swap(small_vector& x)
+    {
+        if (this == &x) {
+            return;
+        }
+        if (!is_inline() && !x.is_inline()) {
+            std::swap(start_, x.start_);
+            std::swap(finish_, x.finish_);
+            std::swap(end_of_storage_, x.end_of_storage_);
+            std::swap(static_cast<data_allocator&>(*this), static_cast<data_allocator&>(x));
+            return;
+        }
+        small_vector tmp(std::move(x));
+        x = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    allocator_type get_allocator() const
+    {
+        return data_allocator::get_allocator();
+    }
+
+    void reserve(size_type n)
+    {
+        if (capacity() < n) {
+            grow(n);
+        }
+    }
+
+    void resize(size_type n)
+    {
+        if (n < size()) {
+            erase(begin() + n, end());
+        } else {
+            reserve_for(n);
+            for (; size() < n; ++finish_) {
+                construct(finish_);
+            }
+        }
+    }
+
+    void resize(size_type n, const value_type& value)
+    {
+        if (n < size()) {
+            erase(begin() + n, end());
+        } else {
+            insert(end(), n - size(), value);
+        }
+    }
+
+    void resize(size_type n, default_init_t)
+    {
+        resize_uninitialized(n);
+    }
+
+    /* 多出的元素不做初始化, 与 vector 相同 */
+    void resize_uninitialized(size_type n)
+    {
+        static_assert(std::is_same<typename __type_traits<T>::has_trivial_default_constructor, __true_type>::value,
+                      "resize_uninitialized requires a trivially default constructible type");
+        if (n < size()) {
+            erase(begin() + n, end());
+        } else {
+            reserve_for(n);
+            finish_ = start_ + n;
+        }
+    }
+
+    /* 元素放得进内联缓冲区时搬回去, 否则把堆上的容量缩到 size() */
+    void shrink_to_fit()
+    {
+        if (is_inline() || capacity() == size()) {
+            return;
+        }
+        if (size() <= N) {
+            iterator old_start = start_;
+            iterator old_finish = finish_;
+            const size_type old_capacity = capacity();
+            finish_ = wkangk_stl::__uninitialized_move_if_noexcept(old_start, old_finish, inline_start());
+            start_ = inline_start();
+            end_of_storage_ = start_ + N;
+            destroy(old_start, old_finish);
+            data_allocator::deallocate(old_start, old_capacity);
+        } else {
+            grow(size());
+        }
+    }
+
+private:
+    typedef __allocator<value_type, Alloc> data_allocator;
+    typedef typename __is_trivially_relocatable<T>::type relocatable;
+
+    /* 调试模式下检查迭代器是否指向 [begin, end]; 只能查出别的容器的迭代器, 查不出失效的迭代器 */
+    bool owns(const_iterator position) const
+    {
+        return start_ <= position && position <= finish_;
+    }
+
+    iterator inline_start() { return reinterpret_cast<iterator>(&buffer_); }
+    const_iterator inline_start() const { return reinterpret_cast<const_iterator>(&buffer_); }
+
+    size_type next_capacity(size_type required) const
+    {
+        return GrowthPolicy::grow(capacity(), required, sizeof(T));
+    }
+
+    void reserve_for(size_type n)
+    {
+        if (capacity() < n) {
+            grow(next_capacity(n));
+        }
+    }
+
+    template <typename Integer>
+    void insert_dispatch(iterator position, Integer n, Integer value, __true_type)
+    {
+        insert(position, (size_type)n, value);
+    }
+
+    template <typename InputIterator>
+    void insert_dispatch(iterator position, InputIterator first, InputIterator last, __false_type)
+    {
+        range_insert(position, first, last, iterator_category(first));
+    }
+
+    template <typename InputIterator>
+    void range_insert(iterator position, InputIterator first, InputIterator last, input_iterator_tag)
+    {
+        for (; first != last; ++first) {
+            position = emplace(position, *first);
+            ++position;
+        }
+    }
+
+    template <typename ForwardIterator>
+    void range_insert(iterator position, ForwardIterator first, ForwardIterator last, forward_iterator_tag);
+
+    /* 在堆上时释放内存, 回到内联缓冲区 */
+    void deallocate()
+    {
+        if (!is_inline()) {
+            data_allocator::deallocate(start_, capacity());
+        }
+        start_ = finish_ = inline_start();
+        end_of_storage_ = start_ + N;
+    }
+
+    /* 析构已有的元素并释放堆上的内存; 构造函数中途出错时析构函数不会执行, 由它清理 */
+    void abandon()
+    {
+        destroy(start_, finish_);
+        deallocate();
+    }
+
+    /* 接管 x 的元素, 调用前 *this 为空并且使用内联缓冲区 */
+    void steal(small_vector& x)
+    {
+        if (x.is_inline()) {
+            finish_ = wkangk_stl::uninitialized_move(x.start_, x.finish_, start_);
+            x.clear();
+            return;
+        }
+        start_ = x.start_;
+        finish_ = x.finish_;
+        end_of_storage_ = x.end_of_storage_;
+        x.start_ = x.finish_ = x.inline_start();
+        x.end_of_storage_ = x.start_ + N;
+    }
+
+    /* 容量改为 n(n >= size() 并且 n > N), 元素搬到堆上 */
+    void grow(size_type n)
+    {
+        if (is_inline()) {
+            relocate_storage(n, __false_type());
+        } else {
+            relocate_storage(n, relocatable());
+        }
+    }
+
+    void relocate_storage(size_type n, __false_type)
+    {
+        iterator new_start = data_allocator::allocate(n);
+        iterator new_finish;
+        try {
+            new_finish = wkangk_stl::__uninitialized_move_if_noexcept(start_, finish_, new_start);
+        } catch (...) {
+            data_allocator::deallocate(new_start, n);
+            throw;
+        }
+        destroy(start_, finish_);
+        deallocate();
+        start_ = new_start;
+        finish_ = new_finish;
+        end_of_storage_ = new_start + n;
+    }
+
+    /* 已经在堆上并且可以平凡搬迁, 整块 realloc */
+    void relocate_storage(size_type n, __true_type)
+    {
+        const size_type old_size = size();
+        start_ = data_allocator::reallocate(start_, capacity(), n);
+        finish_ = start_ + old_size;
+        end_of_storage_ = start_ + n;
+    }
+
+private:
+    iterator    start_;
+    iterator    finish_;
+    iterator    end_of_storage_;
+    typename std::aligned_storage<sizeof(T) * N, alignof(T)>::type buffer_;    /* 内联缓冲区 */
+};
+
+
+template <typename T, size_t N, typename Alloc, typename GrowthPolicy>
+void small_vector<T, N, Alloc, GrowthPolicy>::insert(iterator position, size_type n, const value_type& value)
+{
+    __STL_DEBUG_CHECK(owns(position), "small_vector::insert: iterator does not belong to this small_vector");
+    if (n == 0) {
+        return;
+    }
+
+    /* value 可能引用容器中的元素, 扩容和移动之前先拷贝一份 */
+    value_type value_copy = value;
+    if (static_cast<size_type>(end_of_storage_ - finish_) < n) {
+        const size_type elems_before = position - start_;
+        grow(next_capacity(size() + n));
+        position = start_ + elems_before;
+    }
+
+    const size_type elems_after = finish_ - position;
+    iterator old_finish = finish_;
+    if (elems_after > n) {
+        wkangk_stl::uninitialized_move(finish_ - n, finish_, finish_);
+        finish_ += n;
+        std::move_backward(position, old_finish - n, old_finish);
+        wkangk_stl::__simd_fill_n(position, n, value_copy);
+    } else {
+        wkangk_stl::uninitialized_fill_n(finish_, n - elems_after, value_copy);
+        finish_ += n - elems_after;
+        wkangk_stl::uninitialized_move(position, old_finish, finish_);
+        finish_ += elems_after;
+        wkangk_stl::__simd_fill_n(position, elems_after, value_copy);
+    }
+}
+
+
+template <typename T, size_t N, typename Alloc, typename GrowthPolicy>
+template <typename ForwardIterator>
+void small_vector<T, N, Alloc, GrowthPolicy>::range_insert(iterator position, ForwardIterator first, 
+                                                           ForwardIterator last, forward_iterator_tag)
+{
+    size_type n = 0;
+    wkangk_stl::distance(first, last, n);
+    if (n == 0) {
+        return;
+    }
+
+    if (static_cast<size_type>(end_of_storage_ - finish_) < n) {
+        const size_type elems_before = position - start_;
+        grow(next_capacity(size() + n));
+        position = start_ + elems_before;
+    }
+
+    const size_type elems_after = finish_ - position;
+    iterator old_finish = finish_;
+    if (elems_after > n) {
+        wkangk_stl::uninitialized_move(finish_ - n, finish_, finish_);
+        finish_ += n;
+        std::move_backward(position, old_finish - n, old_finish);
+        std::copy(first, last, position);
+    } else {
+        ForwardIterator mid = first;
+        wkangk_stl::advance(mid, elems_after);
+        wkangk_stl::uninitialized_copy(mid, last, finish_);
+        finish_ += n - elems_after;
+        wkangk_stl::uninitialized_move(position, old_finish, finish_);
+        finish_ += elems_after;
+        std::copy(first, mid, position);
+    }
+}
+
+
+/* 元素是整数/浮点数时按向量比较 */
+template <typename T, size_t N, typename Alloc, typename GrowthPolicy>
+inline bool operator==(const small_vector<T, N, Alloc, GrowthPolicy>& x, const small_vector<T, N, Alloc, GrowthPolicy>& y)
+{
+    return x.size() == y.size() && wkangk_stl::__simd_equal<T>(x.begin(), x.end(), y.begin());
+}
+
+template <typename T, size_t N, typename Alloc, typename GrowthPolicy>
+inline bool operator!=(const small_vector<T, N, Alloc, GrowthPolicy>& x, const small_vector<T, N, Alloc, GrowthPolicy>& y)
+{
+    return !(x == y);
+}
+
+__WKANGK_STL_END_NAMESPACE
+
+#endif	/* !__WKANGK_STL_SMALL_VECTOR_H__ */
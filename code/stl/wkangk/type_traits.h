@@ -20,6 +20,19 @@ class object 形式的参数才会做参数推导 */
 struct __true_type {};
 struct __false_type {};
 
+/* 编译期的 bool 值转为 __true_type/__false_type, 以便同样用来做参数推导 */
+template <bool>
+struct __bool_type
+{
+    typedef __false_type type;
+};
+
+template <>
+struct __bool_type<true>
+{
+    typedef __true_type type;
+};
+
 
 template <typename T>
 struct __type_traits
@@ -197,6 +210,125 @@ struct __type_traits<T*>
 
 
 
+/* -------------------------------------------------------------------------------
+ *     是否为整数类型. 容器的区间构造/插入是模板 (first, last), vector<int> v(10, 1) 
+ * 这样的调用也会匹配上, 需要借助它把两个整数分派到 (n, value) 版本.
+ * ------------------------------------------------------------------------------- */
+template <typename T>
+struct __is_integer
+{
+    typedef __false_type integral;
+};
+
+__STL_TEMPLATE_NULL
+struct __is_integer<bool>
+{
+    typedef __true_type integral;
+};
+
+__STL_TEMPLATE_NULL
+struct __is_integer<char>
+{
+    typedef __true_type integral;
+};
+
+__STL_TEMPLATE_NULL
+struct __is_integer<signed char>
+{
+    typedef __true_type integral;
+};
+
+__STL_TEMPLATE_NULL
+struct __is_integer<unsigned char>
+{
+    typedef __true_type integral;
+};
+
+__STL_TEMPLATE_NULL
+struct __is_integer<wchar_t>
+{
+    typedef __true_type integral;
+};
+
+__STL_TEMPLATE_NULL
+struct __is_integer<char16_t>
+{
+    typedef __true_type integral;
+};
+
+__STL_TEMPLATE_NULL
+struct __is_integer<char32_t>
+{
+    typedef __true_type integral;
+};
+
+__STL_TEMPLATE_NULL
+struct __is_integer<short>
+{
+    typedef __true_type integral;
+};
+
+__STL_TEMPLATE_NULL
+struct __is_integer<unsigned short>
+{
+    typedef __true_type integral;
+};
+
+__STL_TEMPLATE_NULL
+struct __is_integer<int>
+{
+    typedef __true_type integral;
+};
+
+__STL_TEMPLATE_NULL
+struct __is_integer<unsigned int>
+{
+    typedef __true_type integral;
+};
+
+__STL_TEMPLATE_NULL
+struct __is_integer<long>
+{
+    typedef __true_type integral;
+};
+
+__STL_TEMPLATE_NULL
+struct __is_integer<unsigned long>
+{
+    typedef __true_type integral;
+};
+
+__STL_TEMPLATE_NULL
+struct __is_integer<long long>
+{
+    typedef __true_type integral;
+};
+
+__STL_TEMPLATE_NULL
+struct __is_integer<unsigned long long>
+{
+    typedef __true_type integral;
+};
+
+
+/* -------------------------------------------------------------------------------
+ *     可以平凡搬迁(trivially relocatable)的类型: 把对象的字节原样 memcpy/realloc 到
+ * 新地址, 并且不再调用旧对象的析构, 效果与"移动构造新对象 + 析构旧对象"完全相同.
+ *     POD 类型自然可以; 大多数只持有资源句柄/指针, 没有指向自身的指针的类型也可以
+ * (比如只包着一个指针的 handle), 这时可以为它特化:
+ *
+ *     template <> struct __is_trivially_relocatable<my_handle> { typedef __true_type type; };
+ *
+ *     vector 扩容时对这样的类型直接 realloc/memcpy, 没有逐个元素的操作.
+ * ------------------------------------------------------------------------------- */
+template <typename T>
+struct __is_trivially_relocatable
+{
+    typedef typename __type_traits<T>::is_POD_type type;
+};
+
+
+
 __WKANGK_STL_END_NAMESPACE
 
 #endif	/* !__WKANGK_STL_TYPE_TRAITS_H__ */
\ No newline at end of file
@@ -9,11 +9,16 @@ Copyright © wkangk <wangkangchn@163.com>
 #ifndef __WKANGK_STL_UNINITIALIZED_H__ 
 #define __WKANGK_STL_UNINITIALIZED_H__ 
 #include <string.h>
+#include <utility>
 
 #include "config.h"
 #include "construct.h"
 #include "iterator.h"
+#include "simd.h"
 #include "type_traits.h"
+#ifdef __WKANGK_STL_PARALLEL
+#include "parallel.h"
+#endif
 
 
 __WKANGK_STL_BEGIN_NAMESPACE
@@ -29,19 +34,54 @@ ForwardIterator __uninitialized_fill_n_aux(ForwardIterator first, Size n, const
     return std::fill_n(first, n, value);
 }
 
+/* POD 类型的连续区间, 向量化填充 */
+template <typename T, typename Size>
+T* __uninitialized_fill_n_aux(T* first, Size n, const T& value, __true_type)
+{
+    return __simd_fill_n(first, n, value);
+}
 
-/* 非 POD 类型 */
+
+/* 逐个构造, 中途出错时把已经构造的析构掉 */
 template <typename ForwardIterator, typename Size, typename T>
-ForwardIterator __uninitialized_fill_n_aux(ForwardIterator first, Size n, const T& value, __false_type)
+ForwardIterator __uninitialized_fill_n_serial(ForwardIterator first, Size n, const T& value)
 {
     ForwardIterator cur = first;
-    for (; n > 0; --n, ++cur) {
-        /* *cur 是获得接待器数据, & 获得数据地址 */
-        construct(&(*cur), value);
+    try {
+        for (; n > 0; --n, ++cur) {
+            /* *cur 是获得接待器数据, & 获得数据地址 */
+            construct(&(*cur), value);
+        }
+    } catch (...) {
+        destroy(first, cur);
+        throw;
     }
     return cur;
 }
 
+/* 非 POD 类型 */
+template <typename ForwardIterator, typename Size, typename T>
+ForwardIterator __uninitialized_fill_n_aux(ForwardIterator first, Size n, const T& value, __false_type)
+{
+    return __uninitialized_fill_n_serial(first, n, value);
+}
+
+#ifdef __WKANGK_STL_PARALLEL
+/* 连续区间上的非 POD 类型, 元素足够多时分块并行构造, 任何一块出错都把所有块析构掉 */
+template <typename T, typename Size>
+T* __uninitialized_fill_n_aux(T* first, Size n, const T& value, __false_type)
+{
+    const size_t chunks = __parallel_chunks(n);
+    if (chunks < 2) {
+        return __uninitialized_fill_n_serial(first, n, value);
+    }
+    __parallel_chunked(n, chunks,
+        [&](size_t b, size_t e) { __uninitialized_fill_n_serial(first + b, e - b, value); },
+        [&](size_t b, size_t e) { destroy(first + b, first + e); });
+    return first + n;
+}
+#endif
+
 /* T1 迭代器的值 */
 template <typename ForwardIterator, typename Size, typename T, typename T1>
 ForwardIterator __uninitialized_fill_n(ForwardIterator first, Size n, const T& value, T1*)
@@ -73,18 +113,52 @@ ForwardIterator __uninitialized_copy_aux(InputIterator first, InputIterator last
 }
 
 
-/* 非 POD 类型 */
+/* 非 POD 类型, 要么全部构造成功, 要么一个都不留(commit or rollback) */
 template <typename InputIterator, typename ForwardIterator>
-ForwardIterator __uninitialized_copy_aux(InputIterator first, InputIterator last, ForwardIterator result, __false_type)
+ForwardIterator __uninitialized_copy_serial(InputIterator first, InputIterator last, ForwardIterator result)
 {
     ForwardIterator cur = result;
-    for (; first != last; ++cur, ++first) {
-        /* *cur 是获得接待器数据, & 获得数据地址 */
-        construct(&(*cur), *first);
+    try {
+        for (; first != last; ++cur, ++first) {
+            /* *cur 是获得接待器数据, & 获得数据地址 */
+            construct(&(*cur), *first);
+        }
+    } catch (...) {
+        destroy(result, cur);
+        throw;
     }
     return cur;
 }
 
+template <typename InputIterator, typename ForwardIterator>
+ForwardIterator __uninitialized_copy_aux(InputIterator first, InputIterator last, ForwardIterator result, __false_type)
+{
+    return __uninitialized_copy_serial(first, last, result);
+}
+
+#ifdef __WKANGK_STL_PARALLEL
+/* 连续区间分块并行拷贝, 出错时与串行版本一样一个都不留 */
+template <typename T>
+T* __uninitialized_copy_aux(const T* first, const T* last, T* result, __false_type)
+{
+    const size_t n = last - first;
+    const size_t chunks = __parallel_chunks(n);
+    if (chunks < 2) {
+        return __uninitialized_copy_serial(first, last, result);
+    }
+    __parallel_chunked(n, chunks,
+        [&](size_t b, size_t e) { __uninitialized_copy_serial(first + b, first + e, result + b); },
+        [&](size_t b, size_t e) { destroy(result + b, result + e); });
+    return result + n;
+}
+
+template <typename T>
+T* __uninitialized_copy_aux(T* first, T* last, T* result, __false_type)
+{
+    return __uninitialized_copy_aux((const T*)first, (const T*)last, result, __false_type());
+}
+#endif
+
 /* T1 迭代器的值 */
 template <typename InputIterator, typename ForwardIterator, typename T1>
 ForwardIterator __uninitialized_copy(InputIterator first, InputIterator last, ForwardIterator result, T1*)
@@ -118,25 +192,118 @@ wchar_t* uninitialized_copy(const wchar_t* first, const wchar_t* last, wchar_t*
 }
 
 
+/* -------------------------------------------------------------------------------
+ * uninitialized_move
+ * ------------------------------------------------------------------------------- */
+/* POD 类型, 移动就是拷贝 */
+template <typename InputIterator, typename ForwardIterator>
+ForwardIterator __uninitialized_move_aux(InputIterator first, InputIterator last, ForwardIterator result, __true_type)
+{
+    return std::copy(first, last, result);
+}
+
+/* 非 POD 类型, 中途抛出异常时把已经构造的析构掉, 再把异常抛出去 */
+template <typename InputIterator, typename ForwardIterator>
+ForwardIterator __uninitialized_move_aux(InputIterator first, InputIterator last, ForwardIterator result, __false_type)
+{
+    ForwardIterator cur = result;
+    try {
+        for (; first != last; ++cur, ++first) {
+            construct(&(*cur), std::move(*first));
+        }
+    } catch (...) {
+        destroy(result, cur);
+        throw;
+    }
+    return cur;
+}
+
+template <typename InputIterator, typename ForwardIterator, typename T1>
+ForwardIterator __uninitialized_move(InputIterator first, InputIterator last, ForwardIterator result, T1*)
+{   
+    typedef typename __type_traits<T1>::is_POD_type is_POD;
+    return __uninitialized_move_aux(first, last, result, is_POD());
+}
+
+/**
+ *     将 [first, last) 移动到 result 开始的未初始化内存, 源对象仍然需要析构
+ * 返回结束元素的下一个位置
+ */
+template <typename InputIterator, typename ForwardIterator>
+ForwardIterator uninitialized_move(InputIterator first, InputIterator last, ForwardIterator result)
+{
+    return __uninitialized_move(first, last, result, value_type(result));
+}
+
+
+/* 非 POD 类型, 移动构造可能抛出异常并且可以拷贝时退化为拷贝, 源对象保持不变 */
+template <typename InputIterator, typename ForwardIterator>
+ForwardIterator __uninitialized_move_if_noexcept_aux(InputIterator first, InputIterator last, 
+                                                     ForwardIterator result, __false_type)
+{
+    ForwardIterator cur = result;
+    try {
+        for (; first != last; ++cur, ++first) {
+            construct(&(*cur), std::move_if_noexcept(*first));
+        }
+    } catch (...) {
+        destroy(result, cur);
+        throw;
+    }
+    return cur;
+}
+
+template <typename InputIterator, typename ForwardIterator>
+ForwardIterator __uninitialized_move_if_noexcept_aux(InputIterator first, InputIterator last, 
+                                                     ForwardIterator result, __true_type)
+{
+    return std::copy(first, last, result);
+}
+
+/**
+ *     容器扩容时搬迁元素用: 出错时旧内存中的元素必须完好无损, 所以只有移动构造
+ * 不抛异常(或者只能移动)时才移动, 否则拷贝
+ */
+template <typename InputIterator, typename ForwardIterator>
+ForwardIterator __uninitialized_move_if_noexcept(InputIterator first, InputIterator last, ForwardIterator result)
+{
+    typedef typename iterator_traits<ForwardIterator>::value_type T1;
+    typedef typename __type_traits<T1>::is_POD_type is_POD;
+    return __uninitialized_move_if_noexcept_aux(first, last, result, is_POD());
+}
+
+
+
 /* -------------------------------------------------------------------------------
  * uninitialized_fill
  * ------------------------------------------------------------------------------- */
 /* POD 类型 */
-template <typename ForwardIterator, typename Size, typename T>
+template <typename ForwardIterator, typename T>
 void __uninitialized_fill_aux(ForwardIterator first, ForwardIterator last, const T& value, __true_type)
 {
     std::fill(first, last, value);
 }
 
+template <typename T>
+void __uninitialized_fill_aux(T* first, T* last, const T& value, __true_type)
+{
+    __simd_fill_n(first, last - first, value);
+}
+
 
 /* 非 POD 类型 */
-template <typename ForwardIterator, typename Size, typename T>
+template <typename ForwardIterator, typename T>
 void __uninitialized_fill_aux(ForwardIterator first, ForwardIterator last, const T& value, __false_type)
 {
     ForwardIterator cur = first;
-    for (; cur != last; ++cur) {
-        /* *cur 是获得接待器数据, & 获得数据地址 */
-        construct(&(*cur), value);
+    try {
+        for (; cur != last; ++cur) {
+            /* *cur 是获得接待器数据, & 获得数据地址 */
+            construct(&(*cur), value);
+        }
+    } catch (...) {
+        destroy(first, cur);
+        throw;
     }
 }
 
@@ -145,7 +312,7 @@ template <typename ForwardIterator, typename T, typename T1>
 void __uninitialized_fill(ForwardIterator first, ForwardIterator last, const T& value, T1*)
 {   
     typedef typename __type_traits<T1>::is_POD_type is_POD;
-    return __uninitialized_fill_aux(first, last, value, is_POD());
+    __uninitialized_fill_aux(first, last, value, is_POD());
 }
 
 /**
@@ -154,7 +321,7 @@ void __uninitialized_fill(ForwardIterator first, ForwardIterator last, const T&
 template <typename ForwardIterator, typename T>
 void uninitialized_fill(ForwardIterator first, ForwardIterator last, const T& value)
 {
-    return __uninitialized_fill(first, last, value_type(first));
+    __uninitialized_fill(first, last, value, value_type(first));
 }
 
 
@@ -9,20 +9,98 @@ Copyright © wkangk <wangkangchn@163.com>
 #ifndef __WKANGK_STL_VECTOR_HPP__ 
 #define __WKANGK_STL_VECTOR_HPP__ 
 #include <algorithm>
+#include <type_traits>
 
 #include "config.h"
 #include "construct.h"
 #include "alloc.h"
 #include "uninitialized.h"
+#include "debug.h"
 
 
 __WKANGK_STL_BEGIN_NAMESPACE
 
 
+/* -------------------------------------------------------------------------------
+ * 扩容策略
+ *
+ *     一个策略需要提供:
+ *      grow(capacity, required, elem_bytes)    当前容量为 capacity, 至少需要 required 个
+ *                                              元素时的新容量, 返回值 >= required
+ *
+ *     2 倍增长扩容的瞬间需要 3 倍的内存(旧的 1 份 + 新的 2 份), 对几个 GB 的 vector
+ * 来说很容易触发 OOM, 这时可以换用 1.5 倍, 固定步长或者按页增长的策略.
+ * ------------------------------------------------------------------------------- */
+
+/* 按 Num/Den 倍增长, 至少增长一个元素 */
+template <size_t Num, size_t Den>
+struct __factor_growth
+{
+    static_assert(Num > Den && Den > 0, "growth factor must be greater than 1");
+
+    static size_t grow(size_t capacity, size_t required, size_t elem_bytes)
+    {
+        size_t result = capacity / Den * Num + capacity % Den * Num / Den;
+        if (result <= capacity) {
+            result = capacity + 1;
+        }
+        return std::max(result, required);
+    }
+};
+
+typedef __factor_growth<2, 1> __double_growth;
+typedef __factor_growth<3, 2> __golden_growth;      /* 1.5 倍, 释放的旧内存有机会被之后的扩容复用 */
+
+/* 每次增长 Step 个元素, 内存最省, 但是扩容次数与元素个数成正比 */
+template <size_t Step>
+struct __fixed_step_growth
+{
+    static_assert(Step > 0, "Step must be greater than 0");
+
+    static size_t grow(size_t capacity, size_t required, size_t elem_bytes)
+    {
+        return capacity + (required - capacity + Step - 1) / Step * Step;
+    }
+};
+
+/**
+ *     小于 LargeBytes 时 2 倍增长; 超过以后按 1.5 倍增长并且向上取整到整页, 大块内存
+ * 直接来自 mmap, 按页对齐的大小不浪费, 可平凡搬迁的类型 realloc 时还能用 mremap 
+ * 原地扩展.
+ */
+template <size_t LargeBytes = 1 << 20, size_t PageBytes = 4096>
+struct __paged_growth
+{
+    static_assert((PageBytes & (PageBytes - 1)) == 0, "PageBytes must be a power of 2");
+
+    static size_t grow(size_t capacity, size_t required, size_t elem_bytes)
+    {
+        if (capacity * elem_bytes < LargeBytes) {
+            return __double_growth::grow(capacity, required, elem_bytes);
+        }
+        size_t bytes = __golden_growth::grow(capacity, required, elem_bytes) * elem_bytes;
+        bytes = (bytes + PageBytes - 1) & ~(PageBytes - 1);
+        return bytes / elem_bytes;
+    }
+};
+
+
+/* -------------------------------------------------------------------------------
+ *     作为 resize/构造的参数时表示元素只做默认初始化: 平凡默认构造的类型(int/double/
+ * POD 结构)什么都不写, 内存里是什么就是什么. 适合马上就会被整体覆盖的缓冲区, 
+ * 省去一遍清零, 1 GB 的缓冲区也不会在分配时把每一页都碰一遍.
+ *
+ *     vector<char> buf(1 << 30, default_init);
+ *     size_t n = read(fd, buf.begin(), buf.size());
+ * ------------------------------------------------------------------------------- */
+struct default_init_t {};
+static const default_init_t default_init = default_init_t();
+
+
 /* vector 支持动态增长的线性数组, 当现有的存储空间不足时, 
-会以原先大小的 2 倍进行扩充 */
-template <typename T, typename Alloc = alloc>
-class vector
+会按 GrowthPolicy 进行扩充, 默认为原先大小的 2 倍 */
+template <typename T, typename Alloc = alloc, typename GrowthPolicy = __double_growth>
+class vector : private __allocator<T, Alloc>    /* 配置器的实例放在基类中, 无状态时不占空间 */
 {
 public:
     typedef T               value_type;
@@ -34,38 +112,89 @@ public:
     typedef const reference      const_reference;       
     typedef size_t          size_type;       
     typedef ptrdiff_t       difference_type;
+    typedef Alloc           allocator_type;
 
 public:
     vector() : start_(nullptr), finish_(nullptr), end_of_storage_(nullptr) {}
+    explicit vector(const allocator_type& a) : 
+        data_allocator(a), start_(nullptr), finish_(nullptr), end_of_storage_(nullptr) 
+    {
+    }
+
     explicit vector(size_type n)
     {
         fill_initialize(n, T());        /* 从这里就可以看出, 当仅传入一个大小时, 所保存的
                                         类必须支持默认构造 */
     }
-    vector(size_type n, const value_type& value)
+    vector(size_type n, const value_type& value, const allocator_type& a = allocator_type()) :
+        data_allocator(a)
     {
         fill_initialize(n, value);        
     }
 
-    vector(int n, const value_type& value)
+    vector(int n, const value_type& value, const allocator_type& a = allocator_type()) :
+        data_allocator(a)
     {
         fill_initialize(n, value);        
     }
 
-    vector(long n, const value_type& value)
+    vector(long n, const value_type& value, const allocator_type& a = allocator_type()) :
+        data_allocator(a)
     {
         fill_initialize(n, value);
     }
 
-    vector(const_iterator first, const_iterator last) 
+    /* 元素只做默认初始化, 要求 T 可以平凡默认构造 */
+    vector(size_type n, default_init_t, const allocator_type& a = allocator_type()) :
+        data_allocator(a), start_(nullptr), finish_(nullptr), end_of_storage_(nullptr)
     {
-        size_type n = 0;
-        distance(first, last, n);
-        start_ = allocate_and_copy(n, first, last);
-        finish_ = start_ + n;
+        resize_uninitialized(n);
+    }
+
+    /* 区间构造. 两个参数都是整数时(如 vector<long>(10, 1))当作 (n, value) 处理 */
+    template <typename InputIterator>
+    vector(InputIterator first, InputIterator last, const allocator_type& a = allocator_type()) :
+        data_allocator(a), start_(nullptr), finish_(nullptr), end_of_storage_(nullptr)
+    {
+        typedef typename __is_integer<InputIterator>::integral integral;
+        initialize_dispatch(first, last, integral());
+    }
+
+    /* 拷贝时连同配置器一起拷贝 */
+    vector(const vector& x) :
+        data_allocator(x.get_allocator())
+    {
+        start_ = allocate_and_copy(x.size(), x.begin(), x.end());
+        finish_ = start_ + x.size();
         end_of_storage_ = finish_;
     }
 
+    /* 移动时直接接管 x 的内存, 配置器也一起移动过来 */
+    vector(vector&& x) noexcept :
+        data_allocator(std::move(static_cast<data_allocator&>(x))),
+        start_(x.start_), finish_(x.finish_), end_of_storage_(x.end_of_storage_)
+    {
+        x.start_ = x.finish_ = x.end_of_storage_ = nullptr;
+    }
+
+    vector& operator=(const vector& x)
+    {
+        if (this != &x) {
+            vector tmp(x);      /* 先拷贝再交换, 配置器也随之传递过来 */
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    vector& operator=(vector&& x) noexcept
+    {
+        if (this != &x) {
+            vector tmp(std::move(x));   /* 原来的内存随 tmp 析构释放 */
+            swap(tmp);
+        }
+        return *this;
+    }
+
     ~vector()
     {
         // wkangk_stl::destroy(start_, finish_);   /* 先析构 */
@@ -86,10 +215,26 @@ public:
     因为 const 方法不能调用非 const 方法 */
     size_type capacity() const { return static_cast<size_type>(end_of_storage_ - start_); }
     bool empty() const { return finish_ == start_; }
-    reference operator[](size_type n) { return *(begin() + n); }
-    const_reference operator[](size_type n) const { return *(begin() + n); }
-    reference front() { return *begin(); }
-    reference back() { return *(end() - 1); }   /* 区间为左闭右开 */
+    reference operator[](size_type n)
+    {
+        __STL_DEBUG_CHECK(n < size(), "vector::operator[]: index out of range");
+        return *(begin() + n);
+    }
+    const_reference operator[](size_type n) const
+    {
+        __STL_DEBUG_CHECK(n < size(), "vector::operator[]: index out of range");
+        return *(begin() + n);
+    }
+    reference front()
+    {
+        __STL_DEBUG_CHECK(!empty(), "vector::front: empty vector");
+        return *begin();
+    }
+    reference back()    /* 区间为左闭右开 */
+    {
+        __STL_DEBUG_CHECK(!empty(), "vector::back: empty vector");
+        return *(end() - 1);
+    }
     void push_back(const value_type& value)
     {
         if (finish_ != end_of_storage_) {   /* 满了, 就需要进行扩充 */
@@ -100,8 +245,51 @@ public:
         }
     }
 
+    void push_back(value_type&& value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    /* 直接用参数在尾部构造元素, 省去一次临时对象的构造和移动 */
+    template <typename... Args>
+    void emplace_back(Args&&... args)
+    {
+        if (finish_ != end_of_storage_) {
+            construct(finish_, std::forward<Args>(args)...);
+            ++finish_;
+        } else {
+            insert_aux(end(), std::forward<Args>(args)...);
+        }
+    }
+
+    /* 在 position 处用参数构造元素, 返回新元素的位置 */
+    template <typename... Args>
+    iterator emplace(iterator position, Args&&... args)
+    {
+        __STL_DEBUG_CHECK(owns(position), "vector::insert: iterator does not belong to this vector");
+        const size_type n = position - begin();
+        if (finish_ != end_of_storage_ && position == end()) {
+            construct(finish_, std::forward<Args>(args)...);
+            ++finish_;
+        } else {
+            insert_aux(position, std::forward<Args>(args)...);
+        }
+        return begin() + n;
+    }
+
+    iterator insert(iterator position, const value_type& value)
+    {
+        return emplace(position, value);
+    }
+
+    iterator insert(iterator position, value_type&& value)
+    {
+        return emplace(position, std::move(value));
+    }
+
     void pop_back()
     {
+        __STL_DEBUG_CHECK(!empty(), "vector::pop_back: empty vector");
         --finish_;
         destroy(finish_);
     }
@@ -109,8 +297,9 @@ public:
     /* 返回删除位置 */
     iterator erase(iterator position)
     {
+        __STL_DEBUG_CHECK(owns(position) && position != end(), "vector::erase: iterator is not dereferenceable");
         if (position + 1 != end()) {
-            std::copy(position + 1, end(), position);
+            std::move(position + 1, end(), position);
         }
         --finish_;
         destroy(finish_);
@@ -119,7 +308,8 @@ public:
 
     iterator erase(iterator first, iterator last)
     {   
-        auto it = std::copy(last, end(), first);    /* 返回拷贝的尾指针 */
+        __STL_DEBUG_CHECK(owns(first) && owns(last) && first <= last, "vector::erase: invalid range");
+        auto it = std::move(last, end(), first);    /* 返回移动的尾指针 */
         destroy(it, finish_);
         finish_ = finish_ - (last - first);
         return first;
@@ -132,29 +322,123 @@ public:
 
     void insert(iterator postion, size_type n, const value_type& value);
 
-    void swap(vector<T, Alloc>& x) 
+    /**
+     *     插入区间 [first, last). 前向迭代器先用 distance 算出元素个数, 只检查一次容量,
+     * 最多扩容一次, POD 类型整块拷贝; 输入迭代器只能逐个插入.
+     */
+    template <typename InputIterator>
+    void insert(iterator position, InputIterator first, InputIterator last)
+    {
+        __STL_DEBUG_CHECK(owns(position), "vector::insert: iterator does not belong to this vector");
+        typedef typename __is_integer<InputIterator>::integral integral;
+        insert_dispatch(position, first, last, integral());
+    }
+
+    /* 追加到末尾 */
+    template <typename InputIterator>
+    void append(InputIterator first, InputIterator last)
+    {
+        insert(end(), first, last);
+    }
+
+    /* 内容替换为 n 个 value */
+    void assign(size_type n, const value_type& value);
+
+    /* 内容替换为 [first, last), 已有的元素直接赋值, 容量不够时才重新分配 */
+    template <typename InputIterator>
+    void assign(InputIterator first, InputIterator last)
+    {
+        typedef typename __is_integer<InputIterator>::integral integral;
+        assign_dispatch(first, last, integral());
+    }
+
+    void swap(vector& x) 
     {
         std::swap(start_, x.start_);
         std::swap(finish_, x.finish_);
         std::swap(end_of_storage_, x.end_of_storage_);
+        /* 内存跟着配置器走, 所以配置器也要交换 */
+        std::swap(static_cast<data_allocator&>(*this), static_cast<data_allocator&>(x));
+    }
+
+    allocator_type get_allocator() const
+    {
+        return data_allocator::get_allocator();
     }
     
 
     void reserve(size_type n) 
     {
         if (capacity() < n) {
-            const size_type old_size = size();
-            iterator tmp = allocate_and_copy(n, start_, finish_);
-            wkangk_stl::destroy(start_, finish_);
+            relocate_storage(n, relocatable());
+        }
+    }
+
+    /* 多出的元素值初始化(int 为 0) */
+    void resize(size_type n)
+    {
+        if (n < size()) {
+            erase(begin() + n, end());
+        } else {
+            reserve_for(n);
+            for (; static_cast<size_type>(finish_ - start_) < n; ++finish_) {
+                construct(finish_);
+            }
+        }
+    }
+
+    void resize(size_type n, const value_type& value)
+    {
+        if (n < size()) {
+            erase(begin() + n, end());
+        } else {
+            insert(end(), n - size(), value);
+        }
+    }
+
+    void resize(size_type n, default_init_t)
+    {
+        resize_uninitialized(n);
+    }
+
+    /**
+     *     多出的元素不做初始化, 只有平凡默认构造的类型可以用. 之后读取这些元素前
+     * 必须先写入.
+     */
+    void resize_uninitialized(size_type n)
+    {
+        static_assert(std::is_same<typename __type_traits<T>::has_trivial_default_constructor, __true_type>::value,
+                      "resize_uninitialized requires a trivially default constructible type");
+        if (n < size()) {
+            erase(begin() + n, end());
+        } else {
+            reserve_for(n);
+            finish_ = start_ + n;
+        }
+    }
+
+    /* 释放多余的容量, 容量变为 size() */
+    void shrink_to_fit()
+    {
+        if (capacity() == size()) {
+            return;
+        }
+        if (empty()) {
             deallocate();
-            start_ = tmp;
-            finish_ = tmp + old_size;
-            end_of_storage_ = start_ + n;
+        } else {
+            relocate_storage(size(), relocatable());
         }
     }
 
 private:
-    typedef simple_alloc<value_type, Alloc> data_allocator;
+    typedef __allocator<value_type, Alloc> data_allocator;
+    typedef typename __is_trivially_relocatable<T>::type relocatable;
+
+    /* 调试模式下检查迭代器是否指向 [begin, end]; 只能查出别的容器的迭代器, 查不出失效的迭代器 */
+    bool owns(const_iterator position) const
+    {
+        return start_ <= position && position <= finish_;
+    }
 
     /* 使用数据填充指定个数个数据 */
     void fill_initialize(size_type n, const T& value)
@@ -168,7 +452,13 @@ private:
     iterator allocate_and_fill(size_type n, const T& value)
     {
         auto result = data_allocator::allocate(n);
-        return  wkangk_stl::uninitialized_fill_n(result, n, value);
+        try {
+            wkangk_stl::uninitialized_fill_n(result, n, value);     /* 返回的是填充的终点, 不能直接返回 */
+        } catch (...) {
+            data_allocator::deallocate(result, n);
+            throw;
+        }
+        return result;
     }
 
     /* 释放内存 */
@@ -180,13 +470,236 @@ private:
         }
     }
 
-    void insert_aux(iterator position, const value_type& value);
+    template <typename... Args>
+    void insert_aux(iterator position, Args&&... args);
+
+    template <typename Integer>
+    void initialize_dispatch(Integer n, Integer value, __true_type)
+    {
+        fill_initialize(n, value);
+    }
+
+    template <typename InputIterator>
+    void initialize_dispatch(InputIterator first, InputIterator last, __false_type)
+    {
+        range_initialize(first, last, iterator_category(first));
+    }
+
+    template <typename InputIterator>
+    void range_initialize(InputIterator first, InputIterator last, input_iterator_tag)
+    {
+        for (; first != last; ++first) {
+            emplace_back(*first);
+        }
+    }
+
+    template <typename ForwardIterator>
+    void range_initialize(ForwardIterator first, ForwardIterator last, forward_iterator_tag)
+    {
+        size_type n = 0;
+        wkangk_stl::distance(first, last, n);
+        start_ = allocate_and_copy(n, first, last);
+        finish_ = start_ + n;
+        end_of_storage_ = finish_;
+    }
+
+    template <typename Integer>
+    void insert_dispatch(iterator position, Integer n, Integer value, __true_type)
+    {
+        insert(position, (size_type)n, value);
+    }
+
+    template <typename InputIterator>
+    void insert_dispatch(iterator position, InputIterator first, InputIterator last, __false_type)
+    {
+        range_insert(position, first, last, iterator_category(first));
+    }
+
+    template <typename InputIterator>
+    void range_insert(iterator position, InputIterator first, InputIterator last, input_iterator_tag)
+    {
+        for (; first != last; ++first) {
+            position = insert(position, *first);
+            ++position;
+        }
+    }
+
+    template <typename ForwardIterator>
+    void range_insert(iterator position, ForwardIterator first, ForwardIterator last, forward_iterator_tag);
+
+    /* 余量足够, 原地插入 n 个元素 */
+    template <typename ForwardIterator>
+    void range_insert_in_place(iterator position, ForwardIterator first, ForwardIterator last, size_type n);
+
+    /* 可以平凡搬迁时先 realloc, 再原地插入 */
+    template <typename ForwardIterator>
+    void range_insert_realloc(iterator position, ForwardIterator first, ForwardIterator last, 
+                              size_type n, __true_type)
+    {
+        const size_type elems_before = position - start_;
+        relocate_storage(next_capacity(size() + n), __true_type());
+        range_insert_in_place(start_ + elems_before, first, last, n);
+    }
+
+    /* 否则分配新内存, 前半部分, 新区间, 后半部分依次搬过去 */
+    template <typename ForwardIterator>
+    void range_insert_realloc(iterator position, ForwardIterator first, ForwardIterator last, 
+                              size_type n, __false_type);
+
+    template <typename Integer>
+    void assign_dispatch(Integer n, Integer value, __true_type)
+    {
+        assign((size_type)n, value);
+    }
+
+    template <typename InputIterator>
+    void assign_dispatch(InputIterator first, InputIterator last, __false_type)
+    {
+        range_assign(first, last, iterator_category(first));
+    }
+
+    template <typename InputIterator>
+    void range_assign(InputIterator first, InputIterator last, input_iterator_tag)
+    {
+        iterator cur = start_;
+        for (; first != last && cur != finish_; ++first, ++cur) {
+            *cur = *first;
+        }
+        if (first == last) {
+            erase(cur, finish_);
+        } else {
+            range_insert(finish_, first, last, input_iterator_tag());
+        }
+    }
+
+    template <typename ForwardIterator>
+    void range_assign(ForwardIterator first, ForwardIterator last, forward_iterator_tag);
+
+    /* 不能平凡搬迁, 由调用者逐个元素搬迁 */
+    template <typename... Args>
+    bool relocatable_insert(size_type new_size, size_type elems_before, __false_type, Args&&...)
+    {
+        return false;
+    }
+
+    bool relocatable_fill_insert(size_type len, size_type elems_before, size_type n, 
+                                 const value_type& value, __false_type)
+    {
+        return false;
+    }
+
+    bool relocatable_fill_insert(size_type len, size_type elems_before, size_type n, 
+                                 const value_type& value, __true_type)
+    {
+        value_type value_copy = value;
+        relocate_storage(len, __true_type());
+        insert(start_ + elems_before, n, value_copy);
+        return true;
+    }
+
+    /* 先 realloc 扩容, 再当作空间足够的情况插入. 参数可能引用容器中的元素, 所以先构造 */
+    template <typename... Args>
+    bool relocatable_insert(size_type new_size, size_type elems_before, __true_type, Args&&... args)
+    {
+        value_type value_copy(std::forward<Args>(args)...);
+        relocate_storage(new_size, __true_type());
+        if (start_ + elems_before == finish_) {
+            construct(finish_, std::move(value_copy));
+            ++finish_;
+        } else {
+            insert_aux(start_ + elems_before, std::move(value_copy));
+        }
+        return true;
+    }
+
+    /* 保证至少能容纳 n 个元素, 不够时按扩容策略增长 */
+    void reserve_for(size_type n)
+    {
+        if (capacity() < n) {
+            relocate_storage(next_capacity(n), relocatable());
+        }
+    }
+
+    /* 至少容纳 required 个元素时的新容量 */
+    size_type next_capacity(size_type required) const
+    {
+        return GrowthPolicy::grow(capacity(), required, sizeof(T));
+    }
+
+    /* 容量改为 n(n >= size()), 逐个元素移动/拷贝到新内存 */
+    void relocate_storage(size_type n, __false_type)
+    {
+        const size_type old_size = size();
+        iterator tmp = allocate_and_relocate(n, start_, finish_);
+        wkangk_stl::destroy(start_, finish_);
+        deallocate();
+        start_ = tmp;
+        finish_ = tmp + old_size;
+        end_of_storage_ = start_ + n;
+    }
+
+    /**
+     *     扩容插入的最后一步. 新元素已经构造在新内存的 [new_start + (position - start_), +n),
+     * 把 position 前后的旧元素搬到它们两侧, 然后换上新内存.
+     *     旧元素能移动就不拷贝(move_if_noexcept), 移动可能抛异常时才拷贝, 所以出错时
+     * 旧内存中的元素完好无损: 析构新内存中已经构造的元素, 释放新内存, 容器保持原样(强异常保证).
+     */
+    void relocate_around(iterator new_start, size_type len, iterator position, size_type n)
+    {
+        iterator mid = new_start + (position - start_);
+        iterator new_finish = new_start;
+        try {
+            new_finish = wkangk_stl::__uninitialized_move_if_noexcept(start_, position, new_start);
+            new_finish = wkangk_stl::__uninitialized_move_if_noexcept(position, finish_, mid + n);
+        } catch (...) {
+            /* 搬迁函数出错时自己会析构已经搬过去的部分, new_finish 只记录搬完的前半部分 */
+            wkangk_stl::destroy(new_start, new_finish);
+            wkangk_stl::destroy(mid, mid + n);
+            data_allocator::deallocate(new_start, len);
+            throw;
+        }
+
+        wkangk_stl::destroy(start_, finish_);
+        deallocate();
+
+        start_ = new_start;
+        finish_ = new_finish;
+        end_of_storage_ = new_start + len;
+    }
+
+    /* 可以平凡搬迁的类型整块 realloc, 大块内存时可能原地扩展, 连 memcpy 都省了 */
+    void relocate_storage(size_type n, __true_type)
+    {
+        const size_type old_size = size();
+        start_ = data_allocator::reallocate(start_, capacity(), n);
+        finish_ = start_ + old_size;
+        end_of_storage_ = start_ + n;
+    }
 
 
-    iterator allocate_and_copy(size_type n, const_iterator first, const_iterator last) 
+    template <typename ForwardIterator>
+    iterator allocate_and_copy(size_type n, ForwardIterator first, ForwardIterator last) 
     {
         iterator result = data_allocator::allocate(n);
-        wkangk_stl::uninitialized_copy(first, last, result);    /* o 虽然是在命名空间中, 那为啥 stl 命名空间的也会见到??? */
+        try {
+            wkangk_stl::uninitialized_copy(first, last, result);    /* o 虽然是在命名空间中, 那为啥 stl 命名空间的也会见到??? */
+        } catch (...) {
+            data_allocator::deallocate(result, n);
+            throw;
+        }
+        return result;
+    }
+
+    /* 扩容时把旧元素搬到新内存, 能移动就不拷贝 */
+    iterator allocate_and_relocate(size_type n, iterator first, iterator last) 
+    {
+        iterator result = data_allocator::allocate(n);
+        try {
+            wkangk_stl::__uninitialized_move_if_noexcept(first, last, result);
+        } catch (...) {
+            data_allocator::deallocate(result, n);
+            throw;
+        }
         return result;
     }
 
@@ -197,55 +710,50 @@ private:
 };
 
 
-template <typename T, typename Alloc>
-void vector<T, Alloc>::insert_aux(vector<T, Alloc>::iterator position, const vector<T, Alloc>::value_type& value)
+template <typename T, typename Alloc, typename GrowthPolicy>
+template <typename... Args>
+void vector<T, Alloc, GrowthPolicy>::insert_aux(iterator position, Args&&... args)
 {
     if (finish_ != end_of_storage_) {    /* 还有空间, 插入 */
-        /* 现在末尾构造一个对象 */
-        construct(vector<T, Alloc>::end(), vector<T, Alloc>::back());
+        /* 先构造出新元素, args 可能引用的就是容器中的元素, 移动之后就不对了 */
+        value_type value_copy(std::forward<Args>(args)...);
+
+        /* 在末尾用最后一个元素移动构造一个对象 */
+        construct(finish_, std::move(*(finish_ - 1)));
         ++finish_;
 
         /* 将 position 处以及后面的数据向后移动 */
         /* 为何 - 2? 因为数据区间是左闭右开, 所以需要 -1, 而前面 finish 又 ++, 所以还需要再
         -1 */
-        std::copy_backward(position, vector<T, Alloc>::end() - 2, vector<T, Alloc>::end() - 1);
+        std::move_backward(position, finish_ - 2, finish_ - 1);
 
-        // *position = value;           /* 不能直接赋值, const 无法赋值给非 const */
-        vector<T, Alloc>::value_type value_copy = value;
-        *position = value_copy;
+        *position = std::move(value_copy);
 
-    } else {    /* 没有空间了, 就先分配原先空间 2 倍的大小, 而后将数据依次拷贝到新内存中 */
+    } else {    /* 没有空间了, 就按扩容策略分配新的空间, 而后将数据依次搬到新内存中 */
 
-        size_type old_size = size();
-        size_type new_size = old_size != 0 ? old_size * 2 : 1;  // 这里是元素个数
-        auto new_start = data_allocator::allocate(new_size);
-        iterator new_finish = new_start;
+        const size_type new_size = next_capacity(size() + 1);  // 这里是元素个数
+        const size_type elems_before = position - start_;
 
+        if (relocatable_insert(new_size, elems_before, relocatable(), std::forward<Args>(args)...)) {
+            return;
+        }
+        /* 新元素先构造, 理由同上 */
+        iterator new_start = data_allocator::allocate(new_size);
         try {
-            new_finish = uninitialized_copy(begin(), position, new_finish);
-            construct(new_finish, value);
-            ++new_finish;   /* 为何非得在这 ++, 而不在下面 +1
-                            为了方式下面抛出异常时, 能够正确处理构造完成的对象 */
-            uninitialized_copy(position, end(), new_finish);
+            construct(new_start + elems_before, std::forward<Args>(args)...);
         } catch (...) {
-            destroy(new_start, new_finish);
             data_allocator::deallocate(new_start, new_size);
+            throw;
         }
-
-        /* 释放原始内存 */
-        destroy(begin(), end());
-        deallocate();
-
-        start_ = new_start;
-        finish_ = new_finish;
-        end_of_storage_ = start_ + new_size;
+        relocate_around(new_start, new_size, position, 1);
     }
 }
 
 
-template <typename T, typename Alloc>
-void vector<T, Alloc>::insert(iterator position, size_type n, const value_type& value)
+template <typename T, typename Alloc, typename GrowthPolicy>
+void vector<T, Alloc, GrowthPolicy>::insert(iterator position, size_type n, const value_type& value)
 {
+    __STL_DEBUG_CHECK(owns(position), "vector::insert: iterator does not belong to this vector");
     if (n != 0) {
         if (static_cast<size_type>(end_of_storage_ - finish_) >= n) {    /* 余量还够 */
             value_type value_copy = value;
@@ -253,52 +761,153 @@ void vector<T, Alloc>::insert(iterator position, size_type n, const value_type&
             iterator old_finish = finish_;
             if (elems_after > n) {  /* 插入点之后现有元素的数目 > 新增元素个数 */
                 /* 先拷贝多出来的, 再拷贝前面, 最后填充 */
-                wkangk_stl::uninitialized_copy(finish_ - n, finish_, finish_);
+                wkangk_stl::uninitialized_move(finish_ - n, finish_, finish_);
                 finish_ += n;
-                std::copy_backward(position, old_finish - n, old_finish);
-                std::fill(position, position + n, value_copy);
+                std::move_backward(position, old_finish - n, old_finish);
+                wkangk_stl::__simd_fill_n(position, n, value_copy);
             } else {    
                 /* 分开处理有什么特别的吗? 不理解 */
                 wkangk_stl::uninitialized_fill_n(finish_, n - elems_after, value_copy);
                 finish_ += n - elems_after;
-                wkangk_stl::uninitialized_copy(position, old_finish, finish_);
+                wkangk_stl::uninitialized_move(position, old_finish, finish_);
                 finish_ += elems_after;
-                std::fill(position, old_finish, value_copy);
+                wkangk_stl::__simd_fill_n(position, elems_after, value_copy);
             }
         } else {
-            /* 同样, 少了就变为旧长度的两倍 */
-            const size_type old_size = size();
-            const size_type len = old_size + std::max(old_size, n);
+            /* 同样按扩容策略增长 */
+            const size_type len = next_capacity(size() + n);
 
-            iterator new_start = data_allocator::allocate(len);     /* 开辟新内存 */
-            iterator new_finish = new_start;
+            if (relocatable_fill_insert(len, position - start_, n, value, relocatable())) {
+                return;
+            }
 
+            /* value 可能引用容器中的元素, 要在旧元素被移走之前填充 */
+            iterator new_start = data_allocator::allocate(len);     /* 开辟新内存 */
             try {
-                /* 拷贝插入前 */
-                new_finish = wkangk_stl::uninitialized_copy(start_, position, new_start);
-
-                /* 要插入的数据 */
-                new_finish = wkangk_stl::uninitialized_fill_n(new_finish, n, value);
-
-                /* 后半部分 */
-                new_finish = wkangk_stl::uninitialized_copy(position, finish_, new_finish);
+                wkangk_stl::uninitialized_fill_n(new_start + (position - start_), n, value);
             } catch (...) {
-                wkangk_stl::destroy(new_start, new_finish);
                 data_allocator::deallocate(new_start, len);
                 throw;
             }
+            relocate_around(new_start, len, position, n);
+        }
+    }
+}
 
-            /* 删除原来的内存 */
-            wkangk_stl::destroy(start_, finish_);
-            deallocate();
 
-            start_ = new_start;
-            finish_ = new_finish;
-            end_of_storage_ = new_start + len;
-        }
+template <typename T, typename Alloc, typename GrowthPolicy>
+template <typename ForwardIterator>
+void vector<T, Alloc, GrowthPolicy>::range_insert(iterator position, ForwardIterator first, 
+                                                  ForwardIterator last, forward_iterator_tag)
+{
+    if (first == last) {
+        return;
+    }
+
+    size_type n = 0;
+    wkangk_stl::distance(first, last, n);
+    if (static_cast<size_type>(end_of_storage_ - finish_) >= n) {
+        range_insert_in_place(position, first, last, n);
+    } else {
+        range_insert_realloc(position, first, last, n, relocatable());
+    }
+}
+
+
+template <typename T, typename Alloc, typename GrowthPolicy>
+template <typename ForwardIterator>
+void vector<T, Alloc, GrowthPolicy>::range_insert_in_place(iterator position, ForwardIterator first, 
+                                                           ForwardIterator last, size_type n)
+{
+    /* 与 insert(position, n, value) 相同, 只是把填充换成拷贝 */
+    const size_type elems_after = finish_ - position;
+    iterator old_finish = finish_;
+    if (elems_after > n) {
+        wkangk_stl::uninitialized_move(finish_ - n, finish_, finish_);
+        finish_ += n;
+        std::move_backward(position, old_finish - n, old_finish);
+        std::copy(first, last, position);
+    } else {
+        ForwardIterator mid = first;
+        wkangk_stl::advance(mid, elems_after);
+        wkangk_stl::uninitialized_copy(mid, last, finish_);
+        finish_ += n - elems_after;
+        wkangk_stl::uninitialized_move(position, old_finish, finish_);
+        finish_ += elems_after;
+        std::copy(first, mid, position);
+    }
+}
+
+
+template <typename T, typename Alloc, typename GrowthPolicy>
+template <typename ForwardIterator>
+void vector<T, Alloc, GrowthPolicy>::range_insert_realloc(iterator position, ForwardIterator first, 
+                                                          ForwardIterator last, size_type n, __false_type)
+{
+    const size_type len = next_capacity(size() + n);
+    iterator new_start = data_allocator::allocate(len);
+    try {
+        wkangk_stl::uninitialized_copy(first, last, new_start + (position - start_));
+    } catch (...) {
+        data_allocator::deallocate(new_start, len);
+        throw;
+    }
+    relocate_around(new_start, len, position, n);
+}
+
+
+template <typename T, typename Alloc, typename GrowthPolicy>
+void vector<T, Alloc, GrowthPolicy>::assign(size_type n, const value_type& value)
+{
+    if (n > capacity()) {
+        vector tmp(n, value, get_allocator());
+        swap(tmp);
+    } else if (n > size()) {
+        wkangk_stl::__simd_fill_n(start_, size(), value);
+        finish_ = wkangk_stl::uninitialized_fill_n(finish_, n - size(), value);
+    } else {
+        erase(wkangk_stl::__simd_fill_n(start_, n, value), finish_);
     }
 }
 
+
+template <typename T, typename Alloc, typename GrowthPolicy>
+template <typename ForwardIterator>
+void vector<T, Alloc, GrowthPolicy>::range_assign(ForwardIterator first, ForwardIterator last, 
+                                                  forward_iterator_tag)
+{
+    size_type n = 0;
+    wkangk_stl::distance(first, last, n);
+    if (n > capacity()) {   /* 放不下, 整体换一块内存 */
+        iterator tmp = allocate_and_copy(n, first, last);
+        wkangk_stl::destroy(start_, finish_);
+        deallocate();
+        start_ = tmp;
+        finish_ = end_of_storage_ = tmp + n;
+    } else if (n > size()) {
+        ForwardIterator mid = first;
+        wkangk_stl::advance(mid, size());
+        std::copy(first, mid, start_);
+        finish_ = wkangk_stl::uninitialized_copy(mid, last, finish_);
+    } else {
+        erase(std::copy(first, last, start_), finish_);
+    }
+}
+
+
+/* 元素是整数/浮点数时按向量比较 */
+template <typename T, typename Alloc, typename GrowthPolicy>
+inline bool operator==(const vector<T, Alloc, GrowthPolicy>& x, const vector<T, Alloc, GrowthPolicy>& y)
+{
+    return x.size() == y.size() && wkangk_stl::__simd_equal<T>(x.begin(), x.end(), y.begin());
+}
+
+template <typename T, typename Alloc, typename GrowthPolicy>
+inline bool operator!=(const vector<T, Alloc, GrowthPolicy>& x, const vector<T, Alloc, GrowthPolicy>& y)
+{
+    return !(x == y);
+}
+
 __WKANGK_STL_END_NAMESPACE
 
 #endif	/* !__WKANGK_STL_VECTOR_HPP__ */
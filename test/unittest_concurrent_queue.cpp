@@ -0,0 +1,141 @@
+/***************************************************************
+ * @copyright  Copyright © 2026 wkangk.
+ * @file       unittest_concurrent_queue.cpp
+ * @author     wkangk <wangkangchn@163.com>
+ * @version    v1.0
+ * @brief      无界无锁队列: 跨段的顺序、剩余元素的析构以及多线程下不丢不重
+ * @date       2026-10-16 23:40
+ **************************************************************/
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "code/stl/wkangk/concurrent_queue.h"
+
+
+using namespace testing;
+using wkangk_stl::concurrent_queue;
+using wkangk_stl::malloc_alloc;
+
+
+TEST(ConcurrentQueue, FifoAcrossSegments)
+{
+    concurrent_queue<std::string> q;
+    const int n = 5 * (int)concurrent_queue<std::string>::segment_size() + 3;
+    EXPECT_TRUE(q.empty());
+    for (int i = 0; i < n; ++i) {
+        q.push(std::to_string(i));
+    }
+    EXPECT_FALSE(q.empty());
+
+    std::string s;
+    for (int i = 0; i < n; ++i) {
+        ASSERT_TRUE(q.try_pop(s));
+        EXPECT_EQ(s, std::to_string(i));
+    }
+    EXPECT_FALSE(q.try_pop(s));
+    EXPECT_TRUE(q.empty());
+
+    q.emplace(3, 'x');
+    ASSERT_TRUE(q.try_pop(s));
+    EXPECT_EQ(s, "xxx");
+}
+
+
+/* 析构时还没取走的元素也要析构, 包括已经取了一部分的段 */
+TEST(ConcurrentQueue, DestroysLeftovers)
+{
+    std::shared_ptr<int> p(new int(1));
+    {
+        concurrent_queue<std::shared_ptr<int>, malloc_alloc, 4> q;
+        for (int i = 0; i < 10; ++i) {
+            q.push(p);
+        }
+        std::shared_ptr<int> out;
+        for (int i = 0; i < 5; ++i) {
+            ASSERT_TRUE(q.try_pop(out));
+        }
+        out.reset();
+        EXPECT_EQ(p.use_count(), 6);
+    }
+    EXPECT_EQ(p.use_count(), 1);
+}
+
+
+/**
+ *     producers 个线程各放入 per_producer 个不同的数, consumers 个线程取, 取出的和
+ * 必须等于放入的和. 段很小时频繁地挂新段、回收旧段
+ */
+template <typename Queue>
+void transfer(int producers, int consumers)
+{
+    const long per_producer = 20000;
+    const long total = producers * per_producer;
+    Queue q;
+    std::atomic<long> sum(0);
+    std::atomic<long> taken(0);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.push_back(std::thread([&, p] {
+            for (long i = 1; i <= per_producer; ++i) {
+                q.push(p * per_producer + i);
+            }
+        }));
+    }
+    for (int c = 0; c < consumers; ++c) {
+        threads.push_back(std::thread([&] {
+            long v;
+            while (taken.load() < total) {
+                if (q.try_pop(v)) {
+                    sum += v;
+                    ++taken;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+
+    EXPECT_EQ(taken.load(), total);
+    EXPECT_EQ(sum.load(), total * (total + 1) / 2);
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(ConcurrentQueue, ManyProducersManyConsumers)
+{
+    transfer<concurrent_queue<long> >(4, 4);
+    transfer<concurrent_queue<long> >(1, 3);
+    transfer<concurrent_queue<long> >(3, 1);
+    transfer<concurrent_queue<long, malloc_alloc, 2> >(3, 3);
+}
+
+/* 同一个生产者放入的元素按顺序取出 */
+TEST(ConcurrentQueue, SingleProducerOrder)
+{
+    concurrent_queue<long> q;
+    const long n = 100000;
+    std::thread producer([&] {
+        for (long i = 0; i < n; ++i) {
+            q.push(i);
+        }
+    });
+    long expect = 0;
+    long v;
+    while (expect < n) {
+        if (q.try_pop(v)) {
+            EXPECT_EQ(v, expect);
+            ++expect;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+}
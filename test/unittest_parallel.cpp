@@ -0,0 +1,129 @@
+/***************************************************************
+ * @copyright  Copyright © 2026 wkangk.
+ * @file       unittest_parallel.cpp
+ * @author     wkangk <wangkangchn@163.com>
+ * @version    v1.0
+ * @brief      大区间并行构造/析构: 结果、出错后的清理以及嵌套的大区间
+ * @date       2026-10-16 23:58
+ **************************************************************/
+#define __WKANGK_STL_PARALLEL
+#define __WKANGK_STL_PARALLEL_THRESHOLD 1024
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "code/stl/wkangk/vector.h"
+#include "code/stl/wkangk/uninitialized.h"
+#include "code/stl/wkangk/construct.h"
+#include "code/stl/wkangk/parallel.h"
+
+
+using namespace testing;
+using wkangk_stl::__thread_pool;
+
+
+static std::atomic<int> live(0);
+static std::atomic<int> throw_after(-1);      /* 再拷贝这么多次后抛异常, -1 表示不抛 */
+
+struct counted
+{
+    int value;
+
+    counted(int v = 0) : value(v) { ++live; }
+    counted(const counted& x) : value(x.value)
+    {
+        if (throw_after.load() >= 0 && throw_after.fetch_sub(1) == 0) {
+            throw std::runtime_error("copy");
+        }
+        ++live;
+    }
+    ~counted() { --live; }
+};
+
+const size_t N = 10 * __WKANGK_STL_PARALLEL_THRESHOLD;
+
+
+TEST(Parallel, FillCopyDestroy)
+{
+    counted* a = static_cast<counted*>(::operator new(N * sizeof(counted)));
+    counted* b = static_cast<counted*>(::operator new(N * sizeof(counted)));
+
+    wkangk_stl::uninitialized_fill_n(a, N, counted(7));
+    EXPECT_EQ(live.load(), (int)N);
+    for (size_t i = 0; i < N; ++i) {
+        a[i].value += (int)i;
+    }
+    wkangk_stl::uninitialized_copy(a, a + N, b);
+    EXPECT_EQ(live.load(), 2 * (int)N);
+    for (size_t i = 0; i < N; ++i) {
+        ASSERT_EQ(b[i].value, 7 + (int)i);
+    }
+
+    wkangk_stl::destroy(a, a + N);
+    wkangk_stl::destroy(b, b + N);
+    EXPECT_EQ(live.load(), 0);
+    ::operator delete(a);
+    ::operator delete(b);
+
+    wkangk_stl::vector<std::string> v(N, std::string(40, 'x'));
+    wkangk_stl::vector<std::string> w(v);
+    EXPECT_EQ(w.size(), N);
+    EXPECT_EQ(w[N - 1], std::string(40, 'x'));
+}
+
+/* 中途拷贝失败时已经构造的元素全部析构, 异常原样抛出 */
+TEST(Parallel, CleanupAfterPartialFailure)
+{
+    counted* a = static_cast<counted*>(::operator new(N * sizeof(counted)));
+    counted* b = static_cast<counted*>(::operator new(N * sizeof(counted)));
+    wkangk_stl::uninitialized_fill_n(a, N, counted(1));
+
+    throw_after = (int)N / 2;
+    EXPECT_THROW(wkangk_stl::uninitialized_copy(a, a + N, b), std::runtime_error);
+    EXPECT_EQ(live.load(), (int)N);
+
+    throw_after = (int)N - 1;
+    EXPECT_THROW(wkangk_stl::uninitialized_fill_n(b, N, counted(2)), std::runtime_error);
+    EXPECT_EQ(live.load(), (int)N);
+    throw_after = -1;
+
+    wkangk_stl::destroy(a, a + N);
+    EXPECT_EQ(live.load(), 0);
+    ::operator delete(a);
+    ::operator delete(b);
+
+    /* 直接分块: 出错的块自己清理, 其余成功的块各撤销一次 */
+    std::atomic<size_t> undone(0);
+    EXPECT_THROW(wkangk_stl::__parallel_chunked(N, 4,
+        [](size_t b, size_t) {
+            if (b == wkangk_stl::__chunk_begin(N, 4, 2)) {
+                throw std::logic_error("chunk");
+            }
+        },
+        [&](size_t b, size_t e) { undone += e - b; }), std::logic_error);
+    EXPECT_EQ(undone.load(), N - (wkangk_stl::__chunk_begin(N, 4, 3) - wkangk_stl::__chunk_begin(N, 4, 2)));
+}
+
+/* 块中再遇到大区间时串行处理, 包括 run() 的调用者自己处理的块 */
+TEST(Parallel, NestedLargeRange)
+{
+    EXPECT_FALSE(__thread_pool::in_worker());
+    std::atomic<size_t> nested(0);
+    auto fn = [&](size_t) {
+        EXPECT_TRUE(__thread_pool::in_worker());
+        EXPECT_EQ(wkangk_stl::__parallel_chunks(N), 1u);
+        wkangk_stl::vector<std::string> inner(N, std::string("y"));
+        nested += inner.size();
+    };
+    __thread_pool::instance().run(4, fn);
+    EXPECT_EQ(nested.load(), 4 * N);
+    EXPECT_FALSE(__thread_pool::in_worker());
+
+    const size_t M = 2 * __WKANGK_STL_PARALLEL_THRESHOLD;
+    wkangk_stl::vector<wkangk_stl::vector<std::string> > outer(M, wkangk_stl::vector<std::string>(M, "z"));
+    wkangk_stl::vector<wkangk_stl::vector<std::string> > copy(outer);
+    EXPECT_EQ(copy[M - 1][M - 1], "z");
+}
@@ -0,0 +1,248 @@
+/***************************************************************
+ * @copyright  Copyright © 2026 wkangk.
+ * @file       unittest_ring_queue.cpp
+ * @author     wkangk <wangkangchn@163.com>
+ * @version    v1.0
+ * @brief      无锁环形队列: 单线程语义以及多线程下不丢不重
+ * @date       2026-10-16 22:40
+ **************************************************************/
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "code/stl/wkangk/ring_queue.h"
+
+
+using namespace testing;
+using wkangk_stl::ring_queue;
+using wkangk_stl::spsc_tag;
+
+
+template <typename Mode>
+void check_fifo()
+{
+    ring_queue<std::string, Mode> q(5);
+    ASSERT_EQ(q.capacity(), 8u);
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(q.try_push(std::to_string(i)));
+    }
+    EXPECT_FALSE(q.try_push("full"));
+    EXPECT_EQ(q.size(), 8u);
+
+    std::string s;
+    ASSERT_TRUE(q.try_pop(s));
+    EXPECT_EQ(s, "0");
+    EXPECT_TRUE(q.try_emplace(3, 'x'));
+
+    std::vector<std::string> out;
+    EXPECT_EQ(q.try_pop_n(std::back_inserter(out), 100), 8u);
+    ASSERT_EQ(out.size(), 8u);
+    EXPECT_EQ(out[0], "1");
+    EXPECT_EQ(out[7], "xxx");
+    EXPECT_FALSE(q.try_pop(s));
+    EXPECT_TRUE(q.empty());
+
+    /* 绕过一圈以后的批量放入, 多生产者版本要求元素的构造不抛异常 */
+    ring_queue<int, Mode> ints(8);
+    int batch[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    EXPECT_EQ(ints.try_push_n(batch, 5), 5u);
+    EXPECT_EQ(ints.try_pop_n(batch, 5), 5u);
+    EXPECT_EQ(ints.try_push_n(batch, 10), 8u);
+    EXPECT_EQ(ints.try_push_n(batch, 10), 0u);
+    int v;
+    ASSERT_TRUE(ints.try_pop(v));
+    EXPECT_EQ(v, 0);
+}
+
+TEST(RingQueue, Fifo)
+{
+    check_fifo<wkangk_stl::mpmc_tag>();
+    check_fifo<spsc_tag>();
+}
+
+
+/* 析构时队列中剩下的元素也要析构 */
+TEST(RingQueue, DestroysLeftovers)
+{
+    std::shared_ptr<int> p(new int(1));
+    {
+        ring_queue<std::shared_ptr<int> > q(4);
+        ring_queue<std::shared_ptr<int>, spsc_tag> s(4);
+        q.try_push(p);
+        q.try_push(p);
+        s.try_push(p);
+        EXPECT_EQ(p.use_count(), 4);
+    }
+    EXPECT_EQ(p.use_count(), 1);
+}
+
+
+/* 第 limit 次赋值时抛异常的输出迭代器 */
+struct throwing_sink
+{
+    std::vector<std::shared_ptr<int> >* out;
+    size_t limit;
+
+    throwing_sink& operator*() { return *this; }
+    throwing_sink& operator++() { return *this; }
+
+    throwing_sink& operator=(std::shared_ptr<int>&& v)
+    {
+        if (out->size() == limit) {
+            throw std::runtime_error("sink");
+        }
+        out->push_back(std::move(v));
+        return *this;
+    }
+};
+
+/* 批量取出时赋值出错: 已经取走的不会再被析构, 队列之后照常使用 */
+TEST(RingQueue, PopNThrowingOutput)
+{
+    std::shared_ptr<int> p(new int(1));
+    std::vector<std::shared_ptr<int> > out;
+    throwing_sink sink = {&out, 2};
+
+    /* 多生产者版本: 整批槽已经占住, 出错的元素和后面的元素丢弃 */
+    ring_queue<std::shared_ptr<int> > q(8);
+    for (int i = 0; i < 6; ++i) {
+        ASSERT_TRUE(q.try_push(p));
+    }
+    EXPECT_THROW(q.try_pop_n(sink, 100), std::runtime_error);
+    EXPECT_EQ(out.size(), 2u);
+    EXPECT_EQ(p.use_count(), 3);
+    EXPECT_TRUE(q.empty());
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_TRUE(q.try_push(p));
+    }
+    EXPECT_FALSE(q.try_push(p));
+    out.clear();
+    sink.limit = 100;
+    EXPECT_EQ(q.try_pop_n(sink, 100), 8u);
+    out.clear();
+    EXPECT_EQ(p.use_count(), 1);
+
+    /* 单生产者单消费者版本: 出错的元素和后面的元素留在队列中 */
+    ring_queue<std::shared_ptr<int>, spsc_tag> s(8);
+    for (int i = 0; i < 6; ++i) {
+        ASSERT_TRUE(s.try_push(p));
+    }
+    sink.limit = 2;
+    EXPECT_THROW(s.try_pop_n(sink, 100), std::runtime_error);
+    EXPECT_EQ(out.size(), 2u);
+    EXPECT_EQ(s.size(), 4u);
+    EXPECT_EQ(p.use_count(), 7);
+    out.clear();
+    sink.limit = 100;
+    EXPECT_EQ(s.try_pop_n(sink, 100), 4u);
+    out.clear();
+    EXPECT_EQ(p.use_count(), 1);
+    EXPECT_TRUE(s.empty());
+}
+
+
+/**
+ *     producers 个线程各放入 per_producer 个不同的数, consumers 个线程取, 取出的和
+ * 必须等于放入的和. batch 为真时用批量接口
+ */
+template <typename Queue>
+void transfer(int producers, int consumers, bool batch)
+{
+    const long per_producer = 20000;
+    const long total = producers * per_producer;
+    Queue q(64);
+    std::atomic<long> sum(0);
+    std::atomic<long> taken(0);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.push_back(std::thread([&, p] {
+            long next = p * per_producer + 1;
+            const long end = next + per_producer;
+            while (next < end) {
+                size_t pushed;
+                if (batch) {
+                    long buf[16];
+                    size_t n = std::min<long>(16, end - next);
+                    for (size_t i = 0; i < n; ++i) {
+                        buf[i] = next + i;
+                    }
+                    pushed = q.try_push_n(buf, n);
+                } else {
+                    pushed = q.try_push(next) ? 1 : 0;
+                }
+                next += pushed;
+                if (!pushed) {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+    for (int c = 0; c < consumers; ++c) {
+        threads.push_back(std::thread([&] {
+            long buf[16];
+            while (taken.load() < total) {
+                size_t n = batch ? q.try_pop_n(buf, 16) : (q.try_pop(buf[0]) ? 1 : 0);
+                for (size_t i = 0; i < n; ++i) {
+                    sum += buf[i];
+                }
+                taken += n;
+                if (!n) {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+
+    EXPECT_EQ(taken.load(), total);
+    EXPECT_EQ(sum.load(), total * (total + 1) / 2);
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(RingQueue, ManyProducersManyConsumers)
+{
+    for (int batch = 0; batch < 2; ++batch) {
+        transfer<ring_queue<long> >(4, 4, batch);
+        transfer<ring_queue<long> >(1, 3, batch);
+        transfer<ring_queue<long> >(3, 1, batch);
+    }
+}
+
+TEST(RingQueue, SingleProducerSingleConsumer)
+{
+    transfer<ring_queue<long, spsc_tag> >(1, 1, false);
+    transfer<ring_queue<long, spsc_tag> >(1, 1, true);
+
+    /* 只有一个生产者时还要保证顺序 */
+    ring_queue<long, spsc_tag> q(8);
+    const long n = 100000;
+    std::thread producer([&] {
+        for (long i = 0; i < n; ) {
+            if (q.try_push(i)) {
+                ++i;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    long expect = 0;
+    long v;
+    while (expect < n) {
+        if (q.try_pop(v)) {
+            EXPECT_EQ(v, expect);
+            ++expect;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+}
@@ -0,0 +1,86 @@
+/***************************************************************
+ * @copyright  Copyright © 2026 wkangk.
+ * @file       unittest_simd.cpp
+ * @author     wkangk <wangkangchn@163.com>
+ * @version    v1.0
+ * @brief      simd.h 中的算法与 std 同名算法的结果一致
+ * @date       2026-10-16 23:59
+ **************************************************************/
+#include <math.h>
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+#include "code/stl/wkangk/simd.h"
+
+
+using namespace testing;
+
+
+/* 只有 <, 没有 ==; key 相同而 tag 不同的元素是等价的 */
+struct less_only
+{
+    int key;
+    int tag;
+
+    bool operator<(const less_only& x) const { return key < x.key; }
+};
+
+
+TEST(Simd, MinmaxElementIntegers)
+{
+    int a[100];
+    for (int i = 0; i < 100; ++i) {
+        a[i] = (i * 37) % 11 - 5;
+    }
+    std::pair<int*, int*> r = wkangk_stl::minmax_element(a, a + 100);
+    std::pair<int*, int*> e = std::minmax_element(a, a + 100);
+    EXPECT_EQ(r.first, e.first);
+    EXPECT_EQ(r.second, e.second);
+
+    unsigned char u[] = {3, 200, 7, 200, 0, 0};
+    std::pair<unsigned char*, unsigned char*> ru = wkangk_stl::minmax_element(u, u + 6);
+    EXPECT_EQ(ru.first, u + 4);
+    EXPECT_EQ(ru.second, u + 3);
+
+    EXPECT_EQ(wkangk_stl::minmax_element(a, a).first, a);
+}
+
+/* NaN 与谁比较都是假, 位置要与 std 一样, 也不能越界 */
+TEST(Simd, MinmaxElementNaN)
+{
+    double b[] = {1.0, 2.0, NAN};
+    std::pair<double*, double*> r = wkangk_stl::minmax_element(b, b + 3);
+    EXPECT_EQ(r, std::minmax_element(b, b + 3));
+
+    double c[] = {NAN, 1.0, 2.0};
+    r = wkangk_stl::minmax_element(c, c + 3);
+    EXPECT_EQ(r, std::minmax_element(c, c + 3));
+    EXPECT_NE(r.first, c + 3);
+
+    float f[] = {2.0f, NAN, -1.0f, 5.0f, NAN};
+    std::pair<float*, float*> rf = wkangk_stl::minmax_element(f, f + 5);
+    EXPECT_EQ(rf, std::minmax_element(f, f + 5));
+}
+
+TEST(Simd, MinmaxElementLessOnly)
+{
+    less_only v[] = {{2, 0}, {1, 1}, {3, 2}, {1, 3}, {3, 4}};
+    std::pair<less_only*, less_only*> r = wkangk_stl::minmax_element(v, v + 5);
+    EXPECT_EQ(r.first->tag, 1);     /* 第一个最小 */
+    EXPECT_EQ(r.second->tag, 4);    /* 最后一个最大 */
+}
+
+/* 值与元素类型不同时按 == 比较, 不先转换成元素类型 */
+TEST(Simd, FindCountMixedTypes)
+{
+    int a[100];
+    for (int i = 0; i < 100; ++i) {
+        a[i] = i % 5;
+    }
+    EXPECT_EQ(wkangk_stl::count(a, a + 100, 2), 20u);
+    EXPECT_EQ(wkangk_stl::count(a, a + 100, 2.5), 0u);
+    EXPECT_EQ(wkangk_stl::find(a, a + 100, 3), a + 3);
+    EXPECT_EQ(wkangk_stl::find(a, a + 100, 2.5), a + 100);
+    EXPECT_EQ(wkangk_stl::find(a, a + 100, 4.0), a + 4);
+}
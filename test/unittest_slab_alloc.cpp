@@ -0,0 +1,131 @@
+/***************************************************************
+ * @copyright  Copyright © 2026 wkangk.
+ * @file       unittest_slab_alloc.cpp
+ * @author     wkangk <wangkangchn@163.com>
+ * @version    v1.0
+ * @brief      slab_alloc: 大节点、超对齐节点在 clear()/reset() 时也要释放
+ *             泄漏由 -fsanitize=address 的 LeakSanitizer 检查
+ * @date       2026-10-16 23:55
+ **************************************************************/
+#include <stdint.h>
+
+#include <gtest/gtest.h>
+
+#include "code/stl/wkangk/slab.h"
+#include "code/stl/wkangk/list.h"
+#include "code/stl/wkangk/slist.h"
+#include "code/stl/wkangk/map.h"
+
+
+using namespace testing;
+using wkangk_stl::slab_alloc;
+
+
+static int live = 0;
+
+/* 节点超过 __SLAB_MAX_BYTES, 走第一级配置器 */
+struct large_value
+{
+    char payload[2000];
+    int value;
+
+    large_value(int v = 0) : value(v) { ++live; }
+    large_value(const large_value& x) : value(x.value) { ++live; }
+    ~large_value() { --live; }
+};
+
+/* 超过 __ALIGN 对齐, 同样走第一级配置器 */
+struct alignas(64) aligned_value
+{
+    int value;
+};
+
+
+TEST(SlabAlloc, ClearFreesLargeNodes)
+{
+    wkangk_stl::list<large_value, slab_alloc> l;
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 100; ++i) {
+            l.push_back(large_value(i));
+        }
+        EXPECT_EQ(live, 100);
+        l.clear();
+        EXPECT_EQ(live, 0);
+        EXPECT_TRUE(l.empty());
+    }
+    l.push_back(large_value(7));
+    l.push_back(large_value(8));
+    l.pop_front();      /* 单个归还的大块也要从链表中摘下 */
+    EXPECT_EQ(l.front().value, 8);
+
+    wkangk_stl::slist<large_value, slab_alloc> sl;
+    for (int i = 0; i < 100; ++i) {
+        sl.push_front(large_value(i));
+    }
+    sl.clear();
+    EXPECT_TRUE(sl.empty());
+
+    wkangk_stl::map<int, large_value, std::less<int>, slab_alloc> m;
+    for (int i = 0; i < 100; ++i) {
+        m[i] = large_value(i);
+    }
+    m.clear();
+    EXPECT_TRUE(m.empty());
+}
+
+/* 一次性回收时哨兵/header 不在回收之列, clear() 之前取得的 end() 仍然有效 */
+TEST(SlabAlloc, ClearKeepsEnd)
+{
+    wkangk_stl::list<int, slab_alloc> l;
+    wkangk_stl::list<int, slab_alloc>::iterator end = l.end();
+    for (int i = 0; i < 10000; ++i) {      /* 占满多个 slab, 回收后保留的不一定是第一个 */
+        l.push_back(i);
+    }
+    l.clear();
+    EXPECT_TRUE(l.end() == end);
+    EXPECT_TRUE(l.begin() == end);
+    l.push_back(1);
+    EXPECT_TRUE(++l.begin() == end);
+
+    wkangk_stl::map<int, int, std::less<int>, slab_alloc> m;
+    wkangk_stl::map<int, int, std::less<int>, slab_alloc>::iterator mend = m.end();
+    for (int i = 0; i < 10000; ++i) {
+        m[i] = i;
+    }
+    m.clear();
+    EXPECT_TRUE(m.end() == mend);
+    EXPECT_TRUE(m.begin() == mend);
+    m[1] = 1;
+    EXPECT_TRUE(++m.begin() == mend);
+}
+
+TEST(SlabAlloc, ClearFreesOverAlignedNodes)
+{
+    wkangk_stl::list<aligned_value, slab_alloc> l;
+    for (int i = 0; i < 100; ++i) {
+        aligned_value v = {i};
+        l.push_back(v);
+    }
+    for (wkangk_stl::list<aligned_value, slab_alloc>::iterator it = l.begin(); it != l.end(); ++it) {
+        EXPECT_EQ((uintptr_t)&*it % 64, 0u);
+    }
+    l.clear();
+    EXPECT_TRUE(l.empty());
+}
+
+TEST(SlabAlloc, ResetFreesLargeBlocks)
+{
+    slab_alloc a;
+    void* small = a.allocate(32);
+    void* large = a.allocate(4096);
+    void* aligned = a.allocate_aligned(128, 64);
+    EXPECT_EQ((uintptr_t)aligned % 64, 0u);
+    a.deallocate(large, 4096);
+    a.allocate(5000);
+    a.allocate_aligned(256, 128);
+    (void)small;
+    a.reset();
+    EXPECT_GT(a.bytes_reserved(), 0u);      /* slab 保留一块 */
+    a.release();
+    EXPECT_EQ(a.bytes_reserved(), 0u);
+}
@@ -0,0 +1,295 @@
+/***************************************************************
+ * @copyright  Copyright © 2026 wkangk.
+ * @file       unittest_vector_exception.cpp
+ * @author     wkangk <wangkangchn@163.com>
+ * @version    v1.0
+ * @brief      vector 扩容的异常安全: 在元素拷贝和内存分配中注入异常
+ * @date       2026-10-16 19:30
+ **************************************************************/
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "code/stl/wkangk/vector.h"
+#include "code/stl/wkangk/small_vector.h"
+
+
+using namespace testing;
+using wkangk_stl::vector;
+
+
+/* -------------------------------------------------------------------------------
+ *     故障注入: 倒数到 0 时抛出异常, -1 表示不注入
+ * ------------------------------------------------------------------------------- */
+struct fault
+{
+    static int copy_countdown;
+    static int alloc_countdown;
+    static int live;            /* 存活的元素个数, 检查泄漏 */
+    static int blocks;          /* 没有归还的内存块数 */
+
+    static void reset()
+    {
+        copy_countdown = -1;
+        alloc_countdown = -1;
+    }
+
+    static void tick(int& countdown, const char* what)
+    {
+        if (countdown >= 0 && countdown-- == 0) {
+            throw std::runtime_error(what);
+        }
+    }
+};
+
+int fault::copy_countdown = -1;
+int fault::alloc_countdown = -1;
+int fault::live = 0;
+int fault::blocks = 0;
+
+
+/* 拷贝可能抛异常, 移动构造没有 noexcept, 所以扩容时 vector 只能拷贝 */
+struct throwing_copy
+{
+    int value;
+
+    throwing_copy(int v = 0) : value(v) { ++fault::live; }
+    throwing_copy(const throwing_copy& x) : value(x.value)
+    {
+        fault::tick(fault::copy_countdown, "copy");
+        ++fault::live;
+    }
+    throwing_copy(throwing_copy&& x) : value(x.value)
+    {
+        fault::tick(fault::copy_countdown, "move");
+        ++fault::live;
+    }
+    throwing_copy& operator=(const throwing_copy& x)
+    {
+        fault::tick(fault::copy_countdown, "assign");
+        value = x.value;
+        return *this;
+    }
+    ~throwing_copy() { --fault::live; }
+};
+
+
+/* 拷贝可能抛异常, 移动不会, 扩容时搬迁旧元素用移动 */
+struct nothrow_move
+{
+    int value;
+
+    nothrow_move(int v = 0) : value(v) { ++fault::live; }
+    nothrow_move(const nothrow_move& x) : value(x.value)
+    {
+        fault::tick(fault::copy_countdown, "copy");
+        ++fault::live;
+    }
+    nothrow_move(nothrow_move&& x) noexcept : value(x.value) { ++fault::live; }
+    nothrow_move& operator=(const nothrow_move& x)
+    {
+        fault::tick(fault::copy_countdown, "assign");
+        value = x.value;
+        return *this;
+    }
+    nothrow_move& operator=(nothrow_move&& x) noexcept
+    {
+        value = x.value;
+        return *this;
+    }
+    ~nothrow_move() { --fault::live; }
+};
+
+
+/* 分配可能失败的配置器 */
+struct failing_alloc
+{
+    static void* allocate(size_t bytes)
+    {
+        if (fault::alloc_countdown >= 0 && fault::alloc_countdown-- == 0) {
+            throw std::bad_alloc();
+        }
+        ++fault::blocks;
+        return wkangk_stl::malloc_alloc::allocate(bytes);
+    }
+
+    static void deallocate(void* p, size_t bytes)
+    {
+        --fault::blocks;
+        wkangk_stl::malloc_alloc::deallocate(p, bytes);
+    }
+};
+
+
+template <typename Vector>
+Vector make_full(int n)
+{
+    Vector v;
+    v.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        v.push_back(typename Vector::value_type(i));
+    }
+    return v;
+}
+
+template <typename Vector>
+void expect_unchanged(Vector& v, int n, size_t capacity)
+{
+    ASSERT_EQ(v.size(), (size_t)n);
+    EXPECT_EQ(v.capacity(), capacity);
+    for (int i = 0; i < n; ++i) {
+        EXPECT_EQ(v[i].value, i);
+    }
+}
+
+/**
+ *     在第 k 次拷贝/分配时抛出异常, k 从 0 开始递增直到操作成功.
+ * 每次失败后容器必须保持原样(强异常保证), 并且没有泄漏元素.
+ */
+template <typename Vector, typename Op>
+void run_with_faults(int& countdown, Op op)
+{
+    const int n = 8;
+    for (int k = 0; ; ++k) {
+        fault::reset();
+        {
+            Vector v = make_full<Vector>(n);
+            const size_t capacity = v.capacity();
+            const int live_before = fault::live;
+
+            countdown = k;
+            bool thrown = false;
+            try {
+                op(v);
+            } catch (...) {
+                thrown = true;
+            }
+            fault::reset();
+
+            if (!thrown) {
+                break;
+            }
+            expect_unchanged(v, n, capacity);
+            EXPECT_EQ(fault::live, live_before) << "leaked at fault " << k;
+        }
+        EXPECT_EQ(fault::live, 0);
+        ASSERT_LT(k, 1000);
+    }
+    EXPECT_EQ(fault::live, 0);
+}
+
+
+typedef vector<throwing_copy, failing_alloc> copy_vector;
+typedef vector<nothrow_move, failing_alloc> move_vector;
+
+
+template <typename Vector>
+void grow_ops(int& countdown)
+{
+    typedef typename Vector::value_type T;
+    /* 尾部扩容 */
+    run_with_faults<Vector>(countdown, [](Vector& v) { v.push_back(T(100)); });
+    /* 中间插入一个 */
+    run_with_faults<Vector>(countdown, [](Vector& v) { v.insert(v.begin() + 3, T(100)); });
+    run_with_faults<Vector>(countdown, [](Vector& v) { v.emplace(v.begin(), 100); });
+    /* 插入多个 */
+    run_with_faults<Vector>(countdown, [](Vector& v) { v.insert(v.begin() + 5, 4, T(100)); });
+    /* 插入区间 */
+    run_with_faults<Vector>(countdown, [](Vector& v) {
+        T extra[3] = {T(100), T(101), T(102)};
+        v.insert(v.begin() + 2, extra, extra + 3);
+    });
+    /* resize 扩容 */
+    run_with_faults<Vector>(countdown, [](Vector& v) { v.resize(20, T(100)); });
+}
+
+
+TEST(VectorException, CopyFailsDuringGrowth)
+{
+    grow_ops<copy_vector>(fault::copy_countdown);
+    grow_ops<move_vector>(fault::copy_countdown);
+}
+
+TEST(VectorException, AllocationFailsDuringGrowth)
+{
+    grow_ops<copy_vector>(fault::alloc_countdown);
+    grow_ops<move_vector>(fault::alloc_countdown);
+}
+
+TEST(VectorException, ReserveIsStrong)
+{
+    run_with_faults<copy_vector>(fault::copy_countdown, [](copy_vector& v) { v.reserve(100); });
+    run_with_faults<copy_vector>(fault::alloc_countdown, [](copy_vector& v) { v.reserve(100); });
+    run_with_faults<move_vector>(fault::alloc_countdown, [](move_vector& v) { v.reserve(100); });
+}
+
+
+/* 插入的值引用容器自己的元素, 扩容时旧元素被移走之前就要用到它 */
+TEST(VectorException, InsertOwnElementWhileGrowing)
+{
+    vector<std::string> v;
+    v.push_back("first");
+    v.push_back("second");
+    v.shrink_to_fit();
+
+    v.insert(v.begin() + 1, 3, v[0]);
+    ASSERT_EQ(v.size(), 5u);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(v[i], "first");
+    }
+    EXPECT_EQ(v[4], "second");
+
+    v.shrink_to_fit();
+    v.insert(v.begin(), v.back());
+    EXPECT_EQ(v.front(), "second");
+    v.shrink_to_fit();
+    v.push_back(v.front());
+    EXPECT_EQ(v.back(), "second");
+}
+
+
+/* 构造函数中途出错时析构函数不会执行, 已经构造的元素和堆上的内存都要在构造函数中释放 */
+template <typename Op>
+void construct_with_faults(int& countdown, Op op)
+{
+    for (int k = 0; ; ++k) {
+        fault::reset();
+        const int live_before = fault::live;
+        const int blocks_before = fault::blocks;
+        countdown = k;
+        bool thrown = false;
+        try {
+            op();
+        } catch (...) {
+            thrown = true;
+        }
+        fault::reset();
+        EXPECT_EQ(fault::live, live_before) << "leaked at fault " << k;
+        EXPECT_EQ(fault::blocks, blocks_before) << "leaked at fault " << k;
+        if (!thrown) {
+            break;
+        }
+        ASSERT_LT(k, 1000);
+    }
+}
+
+TEST(VectorException, SmallVectorConstructorsFreeStorage)
+{
+    typedef wkangk_stl::small_vector<throwing_copy, 2, failing_alloc> small;
+    {
+        small src;
+        for (int i = 0; i < 8; ++i) {
+            src.push_back(throwing_copy(i));
+        }
+        throwing_copy extra[8];
+        for (int* countdown : {&fault::copy_countdown, &fault::alloc_countdown}) {
+            construct_with_faults(*countdown, [&] { small v(src); });
+            construct_with_faults(*countdown, [&] { small v(8, throwing_copy(1)); });
+            construct_with_faults(*countdown, [&] { small v(extra, extra + 8); });
+        }
+    }
+    EXPECT_EQ(fault::live, 0);
+    EXPECT_EQ(fault::blocks, 0);
+}